@@ -0,0 +1,504 @@
+#ifdef __linux__
+#define _GNU_SOURCE /* CPU_SET(), pthread_setaffinity_np() */
+#endif
+
+#include <ctype.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "cpu.h"
+#include "emu.h"
+
+/*
+ * Jobs are dealt round-robin into one deque per worker before any worker
+ * starts. A worker pops jobs from the bottom of its own deque and, once it
+ * is empty, steals from the top of the others, so the workers that drew
+ * short jobs end up running the long ones the others haven't reached.
+ * Nothing is pushed once the workers run, which leaves the Chase-Lev
+ * deque without its growth path: a worker is done once every deque is
+ * seen empty. Each job gets a fresh instance, and results go into the
+ * job's own slot, so workers share nothing else.
+ */
+#define BATCH_LINE_MAX 4096
+
+typedef struct {
+    char *rom;       /* NULL for the built-in test program */
+    long frames;
+    /* results */
+    const char *status; /* NULL once run to the end */
+    uint64_t cycles;
+    uint64_t hash;
+    double seconds;
+    int worker;
+} batch_job_t;
+
+struct batch_s {
+    batch_job_t *jobs;
+    size_t count;
+};
+
+typedef struct {
+    _Alignas(64) atomic_long top;    /* next job thieves take */
+    _Alignas(64) atomic_long bottom; /* one past the next job the owner takes */
+    size_t *jobs;                    /* indices into batch->jobs */
+} deque_t;
+
+typedef struct worker_s worker_t;
+
+typedef struct {
+    batch_t *batch;
+    const batch_options_t *options;
+    worker_t *workers;
+    int count;
+} pool_t;
+
+struct worker_s {
+    deque_t deque;
+    pool_t *pool;
+    int index;
+    int cpu;         /* CPU to pin to, -1 to leave it to the OS */
+    pthread_t thread;
+};
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/* Owner end, LIFO */
+static bool deque_pop(deque_t *deque, size_t *job)
+{
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    long top;
+
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom)
+    {
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+	return false;
+    }
+
+    *job = deque->jobs[bottom];
+    if (top == bottom)
+    {
+	/* the last job, race the thieves for it */
+	bool won = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+							   memory_order_seq_cst,
+							   memory_order_relaxed);
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+	return won;
+    }
+    return true;
+}
+
+
+/* Thief end, FIFO. Only returns false once the deque is empty. */
+static bool deque_steal(deque_t *deque, size_t *job)
+{
+    for (;;)
+    {
+	long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+	if (top >= bottom)
+	    return false;
+
+	*job = deque->jobs[top];
+	if (atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+						    memory_order_seq_cst,
+						    memory_order_relaxed))
+	{
+	    return true;
+	}
+    }
+}
+
+
+static bool steal_job(worker_t *worker, size_t *job)
+{
+    pool_t *pool = worker->pool;
+
+    for (int i = 1; i < pool->count; i++)
+    {
+	worker_t *victim = &pool->workers[(worker->index + i) % pool->count];
+
+	if (deque_steal(&victim->deque, job))
+	    return true;
+    }
+    return false;
+}
+
+
+static void run_job(batch_job_t *job, const batch_options_t *options, int worker)
+{
+    gb_t *gb = gb_alloc();
+    double start;
+
+    job->worker = worker;
+    if (!gb)
+    {
+	job->status = "out of memory";
+	return;
+    }
+
+    cpu_set_trace_print(gb, false);
+    cpu_set_idle_skip(gb, options->idle_skip);
+    if (options->dynarec)
+	cpu_set_dynarec(gb, true);
+
+    if (job->rom && !emu_load_rom(gb, job->rom))
+    {
+	job->status = "failed to read the ROM";
+	gb_free(gb);
+	return;
+    }
+
+    start = now_seconds();
+    for (long frame = 0; frame < job->frames; frame++)
+    {
+	emu_run_frame(gb);
+    }
+    job->seconds = now_seconds() - start;
+
+    job->cycles = cpu_cycles(gb);
+    job->hash = cpu_state_hash(gb);
+    job->status = NULL;
+    gb_free(gb);
+}
+
+
+static void pin_worker(worker_t *worker)
+{
+#ifdef __linux__
+    cpu_set_t set;
+
+    if (worker->cpu < 0)
+	return;
+    CPU_ZERO(&set);
+    CPU_SET(worker->cpu, &set);
+    /* best effort, the jobs run the same unpinned */
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)worker;
+#endif
+}
+
+
+static void *worker_main(void *arg)
+{
+    worker_t *worker = arg;
+    pool_t *pool = worker->pool;
+    size_t job;
+
+    pin_worker(worker);
+    while (deque_pop(&worker->deque, &job) || steal_job(worker, &job))
+    {
+	run_job(&pool->batch->jobs[job], pool->options, worker->index);
+    }
+    return NULL;
+}
+
+
+/*
+ * The CPUs the process may run on, in order, so worker n can be pinned to
+ * cpus[n]. Returns how many there are, 0 if that can't be found out.
+ */
+static int allowed_cpus(int *cpus, int max)
+{
+    int count = 0;
+#ifdef __linux__
+    cpu_set_t set;
+
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+	return 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && count < max; cpu++)
+    {
+	if (CPU_ISSET(cpu, &set))
+	    cpus[count++] = cpu;
+    }
+#else
+    (void)cpus;
+    (void)max;
+#endif
+    return count;
+}
+
+
+static bool parse_line(batch_job_t *job, char *line)
+{
+    char *rom, *end;
+
+    rom = strtok(line, " \t\r\n");
+    if (!rom)
+	return false;
+    end = strtok(NULL, " \t\r\n");
+    if (!end)
+	return false;
+    job->frames = strtol(end, &end, 0);
+    if (*end != '\0' || job->frames < 0 || strtok(NULL, " \t\r\n"))
+	return false;
+
+    job->rom = NULL;
+    if (strcmp(rom, "-") != 0)
+    {
+	job->rom = strdup(rom);
+	if (!job->rom)
+	    return false;
+    }
+    return true;
+}
+
+
+static void write_csv_string(FILE *file, const char *s)
+{
+    if (!strpbrk(s, ",\"\r\n"))
+    {
+	fputs(s, file);
+	return;
+    }
+    fputc('"', file);
+    for (; *s; s++)
+    {
+	if (*s == '"')
+	    fputc('"', file);
+	fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+
+static void write_json_string(FILE *file, const char *s)
+{
+    fputc('"', file);
+    for (; *s; s++)
+    {
+	if (*s == '"' || *s == '\\')
+	    fprintf(file, "\\%c", *s);
+	else if ((unsigned char)*s < 0x20)
+	    fprintf(file, "\\u%04x", (unsigned char)*s);
+	else
+	    fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/* Read a job manifest, see batch.h. Returns NULL, after saying why on
+ * stderr, if it can't be read or a line doesn't parse. */
+batch_t *batch_load(const char *path)
+{
+    char line[BATCH_LINE_MAX];
+    size_t capacity = 0;
+    int number = 0;
+    batch_t *batch;
+    FILE *file;
+
+    file = fopen(path, "r");
+    if (!file)
+    {
+	fprintf(stderr, "%s: failed to open the manifest\n", path);
+	return NULL;
+    }
+    batch = calloc(1, sizeof(batch_t));
+    if (!batch)
+    {
+	fclose(file);
+	return NULL;
+    }
+
+    while (fgets(line, sizeof(line), file))
+    {
+	char *start = line;
+
+	number++;
+	while (isspace((unsigned char)*start))
+	    start++;
+	if (*start == '\0' || *start == '#')
+	    continue;
+
+	if (batch->count == capacity)
+	{
+	    size_t grown = capacity ? capacity * 2 : 64;
+	    batch_job_t *jobs = realloc(batch->jobs, grown * sizeof(batch_job_t));
+
+	    if (!jobs)
+	    {
+		fprintf(stderr, "%s: out of memory\n", path);
+		goto fail;
+	    }
+	    batch->jobs = jobs;
+	    capacity = grown;
+	}
+
+	memset(&batch->jobs[batch->count], 0, sizeof(batch_job_t));
+	if (!parse_line(&batch->jobs[batch->count], start))
+	{
+	    fprintf(stderr, "%s:%d: expected `ROM FRAMES`\n", path, number);
+	    goto fail;
+	}
+	batch->jobs[batch->count].status = "not run";
+	batch->count++;
+    }
+
+    fclose(file);
+    return batch;
+
+fail:
+    fclose(file);
+    batch_free(batch);
+    return NULL;
+}
+
+
+void batch_free(batch_t *batch)
+{
+    if (!batch)
+	return;
+    for (size_t i = 0; i < batch->count; i++)
+    {
+	free(batch->jobs[i].rom);
+    }
+    free(batch->jobs);
+    free(batch);
+}
+
+
+/*
+ * Run every job and block until they're all done. A job that fails, e.g.
+ * on a missing ROM, is reported as such without stopping the others.
+ * Returns false if the worker threads can't be set up.
+ */
+bool batch_run(batch_t *batch, const batch_options_t *options)
+{
+    pool_t pool = { .batch = batch, .options = options };
+    int threads = options->threads;
+    int *cpus;
+    int cpu_count;
+    size_t *slots;
+    size_t per_worker;
+    int started;
+
+    if (threads <= 0)
+	threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0)
+	threads = 1;
+    if ((size_t)threads > batch->count)
+	threads = batch->count ? (int)batch->count : 1;
+
+    pool.count = threads;
+    per_worker = (batch->count + threads - 1) / threads;
+    pool.workers = aligned_alloc(_Alignof(worker_t), threads * sizeof(worker_t));
+    slots = malloc((per_worker ? threads * per_worker : 1) * sizeof(size_t));
+    cpus = malloc(threads * sizeof(int));
+    if (!pool.workers || !slots || !cpus)
+    {
+	free(pool.workers);
+	free(slots);
+	free(cpus);
+	return false;
+    }
+
+    /* pinning more workers than CPUs would only stack them up */
+    cpu_count = options->pin ? allowed_cpus(cpus, threads) : 0;
+    if (cpu_count < threads)
+	cpu_count = 0;
+
+    for (int i = 0; i < threads; i++)
+    {
+	worker_t *worker = &pool.workers[i];
+	long count = 0;
+
+	worker->deque.jobs = &slots[i * per_worker];
+	for (size_t job = i; job < batch->count; job += threads)
+	{
+	    worker->deque.jobs[count++] = job;
+	}
+	atomic_init(&worker->deque.top, 0);
+	atomic_init(&worker->deque.bottom, count);
+	worker->pool = &pool;
+	worker->index = i;
+	worker->cpu = cpu_count ? cpus[i] : -1;
+    }
+
+    /* worker 0 is this thread */
+    for (started = 1; started < threads; started++)
+    {
+	worker_t *worker = &pool.workers[started];
+
+	if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0)
+	    break;
+    }
+    /* if some failed to start, the others steal their jobs */
+    worker_main(&pool.workers[0]);
+    for (int i = 1; i < started; i++)
+    {
+	pthread_join(pool.workers[i].thread, NULL);
+    }
+
+    free(pool.workers);
+    free(slots);
+    free(cpus);
+    return true;
+}
+
+
+/* Results in manifest order, one line per job, including a header line
+ * for CSV */
+void batch_write(const batch_t *batch, FILE *file, batch_format_e format)
+{
+    if (format == BATCH_FORMAT_CSV)
+	fprintf(file, "job,rom,frames,cycles,hash,seconds,worker,status\n");
+    else
+	fprintf(file, "[\n");
+
+    for (size_t i = 0; i < batch->count; i++)
+    {
+	const batch_job_t *job = &batch->jobs[i];
+	const char *rom = job->rom ? job->rom : "-";
+	const char *status = job->status ? job->status : "ok";
+
+	if (format == BATCH_FORMAT_CSV)
+	{
+	    fprintf(file, "%zu,", i);
+	    write_csv_string(file, rom);
+	    fprintf(file, ",%ld,%llu,%016llx,%.6f,%d,", job->frames,
+		    (unsigned long long)job->cycles, (unsigned long long)job->hash,
+		    job->seconds, job->worker);
+	    write_csv_string(file, status);
+	    fprintf(file, "\n");
+	}
+	else
+	{
+	    fprintf(file, "  {\"job\": %zu, \"rom\": ", i);
+	    write_json_string(file, rom);
+	    fprintf(file, ", \"frames\": %ld, \"cycles\": %llu, \"hash\": \"%016llx\","
+		    " \"seconds\": %.6f, \"worker\": %d, \"status\": ", job->frames,
+		    (unsigned long long)job->cycles, (unsigned long long)job->hash,
+		    job->seconds, job->worker);
+	    write_json_string(file, status);
+	    fprintf(file, "}%s\n", i + 1 < batch->count ? "," : "");
+	}
+    }
+
+    if (format == BATCH_FORMAT_JSON)
+	fprintf(file, "]\n");
+}
@@ -0,0 +1,34 @@
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * Batch runner: runs every job of a manifest on its own emulator instance
+ * across a pool of worker threads and reports how each one ended.
+ *
+ * The manifest has one job per line, `ROM FRAMES`, where ROM is the path
+ * of a ROM image or `-` for the built-in test program. Blank lines and
+ * lines starting with `#` are skipped.
+ */
+typedef struct batch_s batch_t;
+
+typedef enum {
+    BATCH_FORMAT_CSV,
+    BATCH_FORMAT_JSON,
+} batch_format_e;
+
+typedef struct {
+    int threads;     /* worker threads, 0 for one per online CPU */
+    bool pin;        /* pin worker n to the n-th CPU it may run on */
+    bool dynarec;
+    bool idle_skip;
+} batch_options_t;
+
+batch_t *batch_load(const char *path);
+void batch_free(batch_t *batch);
+bool batch_run(batch_t *batch, const batch_options_t *options);
+void batch_write(const batch_t *batch, FILE *file, batch_format_e format);
+
+#endif /* __BATCH_H__ */
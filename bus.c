@@ -0,0 +1,94 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bus.h"
+#include "gb.h"
+
+/* Echo RAM, a mirror of the first 0x1E00 bytes of work RAM */
+#define BUS_ECHO_PAGE  (0xE000 >> GB_PAGE_SHIFT)
+#define BUS_ECHO_PAGES ((0xFE00 - 0xE000) >> GB_PAGE_SHIFT)
+#define BUS_WRAM_PAGE  (0xC000 >> GB_PAGE_SHIFT)
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+static void write_ignored(gb_t *gb, uint16_t address, uint8_t value)
+{
+    (void)gb;
+    (void)address;
+    (void)value;
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/* Plain memory from RAM[] everywhere but echo RAM, which aliases work RAM.
+ * The I/O page is left for the CPU to map. */
+void bus_reset(gb_t *gb)
+{
+    bus_map_memory(gb, 0, GB_PAGES, gb->RAM, true);
+    bus_map_memory(gb, BUS_ECHO_PAGE, BUS_ECHO_PAGES, &gb->RAM[BUS_WRAM_PAGE << GB_PAGE_SHIFT],
+		   true);
+}
+
+
+/*
+ * Map `count` pages from `page` on to the memory at `memory`, a page
+ * after the other. Writes to read-only memory are dropped.
+ */
+void bus_map_memory(gb_t *gb, unsigned page, unsigned count, uint8_t *memory, bool writable)
+{
+    bus_map_read(gb, page, count, memory);
+    for (unsigned i = 0; i < count; i++)
+    {
+	bus_page_t *entry = &gb->bus[page + i];
+
+	entry->write = writable ? memory + ((size_t)i << GB_PAGE_SHIFT) : NULL;
+	entry->write_handler = writable ? NULL : write_ignored;
+    }
+}
+
+
+/* Point the reads of `count` pages from `page` on at `memory`, leaving
+ * the writes as they were, e.g. to switch a bank of ROM in */
+void bus_map_read(gb_t *gb, unsigned page, unsigned count, const uint8_t *memory)
+{
+    bool in_ram = memory >= gb->RAM && memory < gb->RAM + sizeof(gb->RAM);
+
+    for (unsigned i = 0; i < count; i++)
+    {
+	bus_page_t *entry = &gb->bus[page + i];
+	const uint8_t *data = memory + ((size_t)i << GB_PAGE_SHIFT);
+
+	entry->read = data;
+	entry->read_handler = NULL;
+	entry->home = in_ram ? (data - gb->RAM) >> GB_PAGE_SHIFT : page + i;
+    }
+    cpu_pages_remapped(gb);
+}
+
+
+/*
+ * Send the reads, the writes or both of `count` pages from `page` on to
+ * handlers instead of memory. A NULL handler leaves that side as it was.
+ */
+void bus_map_handlers(gb_t *gb, unsigned page, unsigned count, bus_read_handler_t read,
+		      bus_write_handler_t write)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+	bus_page_t *entry = &gb->bus[page + i];
+
+	if (read)
+	{
+	    entry->read = NULL;
+	    entry->read_handler = read;
+	}
+	if (write)
+	{
+	    entry->write = NULL;
+	    entry->write_handler = write;
+	}
+    }
+    cpu_pages_remapped(gb);
+}
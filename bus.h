@@ -0,0 +1,38 @@
+#ifndef __BUS_H__
+#define __BUS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+/*
+ * Memory bus: a table with an entry per 256-byte page of the address
+ * space. Reading or writing a page of plain memory goes straight to the
+ * host memory the entry points at; a page without memory for reads or
+ * writes calls its handler instead, as for I/O registers or writes to
+ * ROM. Pages may point at the same memory, as echo RAM does.
+ *
+ * Every page has a home, the page of the instance's RAM[] its writes are
+ * accounted to: write epochs and the code bits of decoded blocks are kept
+ * per home page. It is the page of RAM[] the memory belongs to, or the
+ * page itself for memory from elsewhere.
+ */
+typedef uint8_t (*bus_read_handler_t)(gb_t *gb, uint16_t address);
+typedef void (*bus_write_handler_t)(gb_t *gb, uint16_t address, uint8_t value);
+
+typedef struct {
+    const uint8_t *read; /* memory the page reads from, NULL for read_handler */
+    uint8_t *write;      /* memory the page writes to, NULL for write_handler */
+    bus_read_handler_t read_handler;
+    bus_write_handler_t write_handler;
+    uint8_t home;
+} bus_page_t;
+
+void bus_reset(gb_t *gb);
+void bus_map_memory(gb_t *gb, unsigned page, unsigned count, uint8_t *memory, bool writable);
+void bus_map_read(gb_t *gb, unsigned page, unsigned count, const uint8_t *memory);
+void bus_map_handlers(gb_t *gb, unsigned page, unsigned count, bus_read_handler_t read,
+		      bus_write_handler_t write);
+
+#endif /* __BUS_H__ */
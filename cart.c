@@ -0,0 +1,199 @@
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cart.h"
+#include "gb.h"
+#include "mbc.h"
+#include "save.h"
+
+/*
+ * The mapping is a whole number of banks, at least two. It is reserved
+ * as anonymous zero pages first and the file mapped over its start, so a
+ * ROM of an odd size reads zeros past its end instead of faulting.
+ */
+#define CART_HEADER_TYPE     0x147
+#define CART_HEADER_RAM_SIZE 0x149
+
+/* Cartridge RAM by the header's RAM size code */
+static const size_t ram_sizes[] = { 0, 0x800, 0x2000, 0x8000, 0x20000, 0x10000 };
+
+struct cart_s {
+    atomic_uint refs;
+    const uint8_t *rom;
+    size_t size;      /* of the mapping */
+    size_t banks;
+    uint8_t type;     /* from the header, 0 for a ROM without a mapper */
+    size_t ram_size;
+};
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+
+/* Free the inserted cartridge's RAM, writing it out first if it is kept
+ * in a save file */
+static void ram_free(gb_t *gb)
+{
+    if (gb->save)
+	save_close(gb->save);
+    else
+	free(gb->cart_ram);
+    gb->save = NULL;
+    gb->cart_ram = NULL;
+    gb->cart_ram_size = 0;
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/* Map the ROM file at `path`, with one reference for the caller. NULL if
+ * it can't be read, is empty or is larger than CART_BANKS_MAX banks. */
+cart_t *cart_open(const char *path)
+{
+    cart_t *cart;
+    struct stat st;
+    size_t banks;
+    uint8_t *rom;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+	return NULL;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 ||
+	(size_t)st.st_size > (size_t)CART_BANKS_MAX * CART_BANK_SIZE)
+    {
+	close(fd);
+	return NULL;
+    }
+    banks = ((size_t)st.st_size + CART_BANK_SIZE - 1) / CART_BANK_SIZE;
+    if (banks < 2)
+	banks = 2;
+
+    cart = malloc(sizeof(cart_t));
+    rom = mmap(NULL, banks * CART_BANK_SIZE, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (!cart || rom == MAP_FAILED ||
+	mmap(rom, st.st_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+	if (rom != MAP_FAILED)
+	    munmap(rom, banks * CART_BANK_SIZE);
+	free(cart);
+	close(fd);
+	return NULL;
+    }
+    close(fd);
+
+    atomic_init(&cart->refs, 1);
+    cart->rom = rom;
+    cart->size = banks * CART_BANK_SIZE;
+    cart->banks = banks;
+    cart->type = rom[CART_HEADER_TYPE];
+    cart->ram_size = 0;
+    if (rom[CART_HEADER_RAM_SIZE] < sizeof(ram_sizes) / sizeof(ram_sizes[0]))
+	cart->ram_size = ram_sizes[rom[CART_HEADER_RAM_SIZE]];
+    return cart;
+}
+
+
+/* Another reference to `cart`, which may be released from any thread */
+cart_t *cart_retain(cart_t *cart)
+{
+    atomic_fetch_add(&cart->refs, 1);
+    return cart;
+}
+
+
+void cart_release(cart_t *cart)
+{
+    if (!cart || atomic_fetch_sub(&cart->refs, 1) != 1)
+	return;
+    munmap((void *)cart->rom, cart->size);
+    free(cart);
+}
+
+
+size_t cart_banks(const cart_t *cart)
+{
+    return cart->banks;
+}
+
+
+/* Bank `bank` of the ROM, wrapping around past the last one as the
+ * mappers do */
+const uint8_t *cart_bank(const cart_t *cart, size_t bank)
+{
+    return cart->rom + bank % cart->banks * CART_BANK_SIZE;
+}
+
+
+/* The cartridge type from the header, which says the mapper */
+uint8_t cart_type(const cart_t *cart)
+{
+    return cart->type;
+}
+
+
+/* Bytes of RAM on the cartridge, from the header */
+size_t cart_ram_size(const cart_t *cart)
+{
+    return cart->ram_size;
+}
+
+
+/*
+ * Insert `cart` into `gb`, taking a reference to it, with its RAM cleared
+ * and its mapper just powered on (see mbc.h). Returns false, leaving `gb`
+ * as it was, if out of memory.
+ */
+bool cart_insert(gb_t *gb, cart_t *cart)
+{
+    uint8_t *ram = NULL;
+
+    if (cart->ram_size && !(ram = calloc(1, cart->ram_size)))
+	return false;
+    cart_retain(cart);
+    cart_release(gb->cart);
+    gb->cart = cart;
+    ram_free(gb);
+    gb->cart_ram = ram;
+    gb->cart_ram_size = cart->ram_size;
+    mbc_reset(gb);
+    return true;
+}
+
+
+/* Take the cartridge out of `gb`, if there is one, e.g. as it is freed */
+void cart_eject(gb_t *gb)
+{
+    ram_free(gb);
+    cart_release(gb->cart);
+    gb->cart = NULL;
+}
+
+
+/*
+ * Keep the inserted cartridge's RAM in the save file at `path` from now
+ * on, see save.h, syncing it to disk every `interval_ms`. The RAM is what
+ * the file holds, zeros for a new one. Returns false, with the RAM left
+ * as it was, if the cartridge has no RAM or the file can't be mapped.
+ */
+bool cart_attach_save(gb_t *gb, const char *path, unsigned interval_ms)
+{
+    size_t size = gb->cart_ram_size;
+    save_t *save;
+
+    if (!gb->cart || size == 0)
+	return false;
+    save = save_open(path, size, interval_ms);
+    if (!save)
+	return false;
+    ram_free(gb);
+    gb->save = save;
+    gb->cart_ram = save_memory(save);
+    gb->cart_ram_size = size;
+    gb->save_epoch = gb_epoch_start(gb);
+    mbc_map(gb);
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef __CART_H__
+#define __CART_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+/*
+ * Cartridges: the ROM file is mapped read-only into the address space of
+ * the host, never copied, so a large ROM opens at once and every instance
+ * of it, in this process or any other, reads the same physical pages.
+ * A cartridge is reference counted, and any number of instances may have
+ * it inserted.
+ *
+ * Inserted, bank 0 is mapped at 0x0000-0x3FFF and the switchable bank at
+ * 0x4000-0x7FFF, straight from the file: switching banks repoints the
+ * pages of the bus at another 16KB of the mapping. Writes to ROM go to the
+ * mapper's write handler, see mbc.h, reads never touch it.
+ */
+#define CART_BANK_SIZE  0x4000
+#define CART_BANKS_MAX  512   /* 8MB, as much as MBC5 can address */
+
+typedef struct cart_s cart_t;
+
+cart_t *cart_open(const char *path);
+cart_t *cart_retain(cart_t *cart);
+void cart_release(cart_t *cart);
+size_t cart_banks(const cart_t *cart);
+const uint8_t *cart_bank(const cart_t *cart, size_t bank);
+uint8_t cart_type(const cart_t *cart);
+size_t cart_ram_size(const cart_t *cart);
+
+bool cart_insert(gb_t *gb, cart_t *cart);
+void cart_eject(gb_t *gb);
+bool cart_attach_save(gb_t *gb, const char *path, unsigned interval_ms);
+
+#endif /* __CART_H__ */
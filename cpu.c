@@ -1,337 +1,1366 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "bus.h"
 #include "cpu.h"
+#include "gb.h"
 #include "opcode.h"
 #include "operand.h"
-#include "register.h"
 #include "errno.h"
 
-typedef struct {
-    union {
-	struct {
-	    uint8_t A; /* Accumulator */
-	    union {
-		uint8_t F; /* Flags */
-		struct {
-		    uint8_t _ :4; /* Bit 0-3 unused */
-		    uint8_t c :1; /* Bit 4 -> Carry flag */
-		    uint8_t h :1; /* Bit 5 -> Bit Half Carry flag (BCD) */
-		    uint8_t n :1; /* Bit 6 -> Subtraction flag (BCD) */
-		    uint8_t z :1; /* Bit 7 -> Zero flag */
-		} F_bits;
-	    };
-	};
-	uint16_t AF;
-    };
-    union {
-	struct {
-	    uint8_t B;
-	    uint8_t C;
-	};
-	uint16_t BC;
-    };
-    union {
-	struct {
-	    uint8_t D;
-	    uint8_t E;
-	};
-	uint16_t DE;
-};
-    union {
-	struct {
-	    uint8_t H;
-	    uint8_t L;
-	};
-	uint16_t HL;
-    };
-    uint16_t SP; /* Stack Pointer */
-    uint16_t PC; /* Program Counter */
-    uint16_t IR; /* Instruction Register */
-} registers_t;
+/*
+ * Lazy flags. ALU instructions only record what they did, and Z/N/H/C are
+ * worked out when something actually reads them (conditional branches,
+ * PUSH AF, DAA, ADC/SBC, state dumps). Most flag results are overwritten
+ * before they are read. Build with -DCPU_EAGER_FLAGS to materialise F
+ * after every ALU instruction instead.
+ */
+#define FLAG_Z 0x80
+#define FLAG_N 0x40
+#define FLAG_H 0x20
+#define FLAG_C 0x10
 
-typedef struct {
-    registers_t reg;
-    uint8_t RAM[0xFFFF + 0x0001];
-} cpu_t;
-
-static cpu_t cpu = {0};
+typedef enum {
+    FLAGS_NONE = 0, /* reg.F is up to date */
+    FLAGS_ADD,      /* a + b + carry */
+    FLAGS_SUB,      /* a - b - carry, also CP */
+    FLAGS_AND,
+    FLAGS_OR,       /* OR and XOR */
+    FLAGS_INC,      /* a + 1, C flag kept in carry */
+    FLAGS_DEC,      /* a - 1, C flag kept in carry */
+    FLAGS_SHIFT,    /* CB rotates and shifts, carry is the bit shifted out */
+    FLAGS_BIT,      /* BIT, result is the tested bit, C flag kept in carry */
+} flags_op_e;
 
 
 /* ======= PRIVATE FUNCTIONS ======= */
-static int read_register(register_e registerType, uint16_t* value)
+static void block_invalidate(gb_t *gb, uint16_t address);
+
+/*
+ * The page table, see bus.h. Plain memory is a lookup and a dereference,
+ * other pages go to their handlers. Writes to memory stamp the home page
+ * with the write epoch and drop the blocks decoded from the byte.
+ */
+inline static uint8_t bus_read(gb_t *gb, uint16_t address)
 {
-    switch(registerType) 
+    const bus_page_t *page = &gb->bus[address >> GB_PAGE_SHIFT];
+
+    if (page->read)
+	return page->read[address & (GB_PAGE_SIZE - 1)];
+    return page->read_handler(gb, address);
+}
+
+
+inline static void bus_write(gb_t *gb, uint16_t address, uint8_t value)
+{
+    const bus_page_t *page = &gb->bus[address >> GB_PAGE_SHIFT];
+    uint16_t home;
+
+    if (!page->write)
     {
-	case REGISTER_A:
-	{
-	    *value = cpu.reg.A;
-	} break;
-	case REGISTER_F:
-	{
-	    *value = cpu.reg.F;
-	} break;
-	case REGISTER_C:
-	{
-	    *value = cpu.reg.C;
-	} break;
-	case REGISTER_B:
+	page->write_handler(gb, address, value);
+	return;
+    }
+    page->write[address & (GB_PAGE_SIZE - 1)] = value;
+    gb->page_epoch[page->home] = gb->epoch;
+    home = page->home << GB_PAGE_SHIFT | (address & (GB_PAGE_SIZE - 1));
+    if (gb->code_bitmap[home >> 3] & (1 << (home & 7)))
+    {
+	block_invalidate(gb, home);
+    }
+}
+
+
+/* A write to RAM[] for the handlers of pages that are partly memory, as
+ * bus_write() does it */
+inline static void ram_write(gb_t *gb, uint16_t address, uint8_t value)
+{
+    gb->RAM[address] = value;
+    gb->page_epoch[address >> GB_PAGE_SHIFT] = gb->epoch;
+    if (gb->code_bitmap[address >> 3] & (1 << (address & 7)))
+    {
+	block_invalidate(gb, address);
+    }
+}
+
+
+/* The last page: I/O registers, HRAM and IE */
+static uint8_t io_page_read(gb_t *gb, uint16_t address)
+{
+    if (io_address(address))
+	return io_read(&gb->io, address, gb->cycles);
+    return gb->RAM[address];
+}
+
+
+static void io_page_write(gb_t *gb, uint16_t address, uint8_t value)
+{
+    if (io_address(address))
+    {
+	io_write(&gb->io, address, value, gb->cycles);
+	return;
+    }
+    ram_write(gb, address, value);
+}
+
+
+/* Tile data in VRAM, read as plain memory. Writes also mark the tile for
+ * the PPU to decode again, see ppu.h. */
+static void tile_data_write(gb_t *gb, uint16_t address, uint8_t value)
+{
+    ram_write(gb, address, value);
+    ppu_tile_written(&gb->ppu, address);
+}
+
+
+inline static uint8_t read_byte_at_pc(gb_t *gb, bool immediate)
+{
+    uint8_t byte;
+
+    byte = gb_peek(gb, gb->reg.PC);
+    gb->reg.PC++;
+    if (!immediate)
+    {
+	byte = bus_read(gb, byte);
+    }
+
+    return byte;
+}
+
+
+inline static uint16_t read_short_at_pc(gb_t *gb, bool immediate)
+{
+    /* first read the value at the program counter
+     * remembering that it is little endian*/
+    uint16_t value = (uint16_t)read_byte_at_pc(gb, true);
+    value |= ((uint16_t)read_byte_at_pc(gb, true) << 8);
+
+    /* if this operand is not immediate, we must follow the pointer first */
+    if (!immediate)
+    {
+	value = bus_read(gb, value);
+    }
+
+    return value;
+}
+
+
+/* Operand bytes following an opcode of the given total length */
+inline static uint16_t read_operand(gb_t *gb, uint8_t length)
+{
+    switch(length)
+    {
+	case 2: return read_byte_at_pc(gb, true);
+	case 3: return read_short_at_pc(gb, true);
+	default: return 0;
+    }
+}
+
+
+/* ======= FLAGS ======= */
+static void flags_materialize(gb_t *gb)
+{
+    lazy_flags_t *flags = &gb->flags;
+    uint8_t f = flags->result == 0 ? FLAG_Z : 0;
+
+    switch(flags->op)
+    {
+	case FLAGS_NONE:
 	{
-	    *value = cpu.reg.B;
-	} break;
-	case REGISTER_D:
+	    return;
+	}
+	case FLAGS_ADD:
 	{
-	    *value = cpu.reg.D;
+	    if ((flags->a & 0xF) + (flags->b & 0xF) + flags->carry > 0xF)
+		f |= FLAG_H;
+	    if (flags->a + flags->b + flags->carry > 0xFF)
+		f |= FLAG_C;
 	} break;
-	case REGISTER_E:
+	case FLAGS_SUB:
 	{
-	    *value = cpu.reg.E;
+	    f |= FLAG_N;
+	    if ((flags->a & 0xF) < (flags->b & 0xF) + flags->carry)
+		f |= FLAG_H;
+	    if (flags->a < flags->b + flags->carry)
+		f |= FLAG_C;
 	} break;
-	case REGISTER_H:
+	case FLAGS_AND:
 	{
-	    *value = cpu.reg.H;
+	    f |= FLAG_H;
 	} break;
-	case REGISTER_L:
+	case FLAGS_OR:
 	{
-	    *value = cpu.reg.L;
 	} break;
-	case REGISTER_AF:
+	case FLAGS_INC:
 	{
-	    *value = cpu.reg.AF;
+	    if ((flags->a & 0xF) == 0xF)
+		f |= FLAG_H;
+	    if (flags->carry)
+		f |= FLAG_C;
 	} break;
-	case REGISTER_BC:
+	case FLAGS_DEC:
 	{
-	    *value = cpu.reg.BC;
+	    f |= FLAG_N;
+	    if ((flags->a & 0xF) == 0)
+		f |= FLAG_H;
+	    if (flags->carry)
+		f |= FLAG_C;
 	} break;
-	case REGISTER_DE:
+	case FLAGS_SHIFT:
 	{
-	    *value = cpu.reg.DE;
+	    if (flags->carry)
+		f |= FLAG_C;
 	} break;
-	case REGISTER_HL:
+	case FLAGS_BIT:
 	{
-	    *value = cpu.reg.HL;
+	    f |= FLAG_H;
+	    if (flags->carry)
+		f |= FLAG_C;
 	} break;
-	default:
+    }
+    gb->reg.F = f;
+    flags->op = FLAGS_NONE;
+}
+
+
+inline static void flags_record(gb_t *gb, flags_op_e op, uint8_t a, uint8_t b,
+				uint8_t carry, uint8_t result)
+{
+    gb->flags.op = op;
+    gb->flags.a = a;
+    gb->flags.b = b;
+    gb->flags.carry = carry;
+    gb->flags.result = result;
+#ifdef CPU_EAGER_FLAGS
+    flags_materialize(gb);
+#endif
+}
+
+
+inline static uint8_t flags_get(gb_t *gb)
+{
+    flags_materialize(gb);
+    return gb->reg.F;
+}
+
+
+inline static void flags_set(gb_t *gb, uint8_t f)
+{
+    gb->reg.F = f & 0xF0;
+    gb->flags.op = FLAGS_NONE;
+}
+
+
+/* Single flag reads only evaluate the flag they need */
+inline static bool flag_z(gb_t *gb)
+{
+    if (gb->flags.op == FLAGS_NONE)
+	return gb->reg.F & FLAG_Z;
+    return gb->flags.result == 0;
+}
+
+
+inline static bool flag_c(gb_t *gb)
+{
+    lazy_flags_t *flags = &gb->flags;
+
+    switch(flags->op)
+    {
+	case FLAGS_NONE: return gb->reg.F & FLAG_C;
+	case FLAGS_ADD: return flags->a + flags->b + flags->carry > 0xFF;
+	case FLAGS_SUB: return flags->a < flags->b + flags->carry;
+	case FLAGS_INC:
+	case FLAGS_DEC:
+	case FLAGS_SHIFT:
+	case FLAGS_BIT: return flags->carry;
+	default: return false;
+    }
+}
+
+
+/* ======= ALU ======= */
+inline static void alu_add(gb_t *gb, uint8_t value)
+{
+    uint8_t a = gb->reg.A;
+    gb->reg.A = a + value;
+    flags_record(gb, FLAGS_ADD, a, value, 0, gb->reg.A);
+}
+
+
+inline static void alu_adc(gb_t *gb, uint8_t value)
+{
+    uint8_t a = gb->reg.A;
+    uint8_t carry = flag_c(gb);
+    gb->reg.A = a + value + carry;
+    flags_record(gb, FLAGS_ADD, a, value, carry, gb->reg.A);
+}
+
+
+inline static void alu_sub(gb_t *gb, uint8_t value)
+{
+    uint8_t a = gb->reg.A;
+    gb->reg.A = a - value;
+    flags_record(gb, FLAGS_SUB, a, value, 0, gb->reg.A);
+}
+
+
+inline static void alu_sbc(gb_t *gb, uint8_t value)
+{
+    uint8_t a = gb->reg.A;
+    uint8_t carry = flag_c(gb);
+    gb->reg.A = a - value - carry;
+    flags_record(gb, FLAGS_SUB, a, value, carry, gb->reg.A);
+}
+
+
+inline static void alu_cp(gb_t *gb, uint8_t value)
+{
+    flags_record(gb, FLAGS_SUB, gb->reg.A, value, 0, gb->reg.A - value);
+}
+
+
+inline static void alu_and(gb_t *gb, uint8_t value)
+{
+    gb->reg.A &= value;
+    flags_record(gb, FLAGS_AND, 0, 0, 0, gb->reg.A);
+}
+
+
+inline static void alu_xor(gb_t *gb, uint8_t value)
+{
+    gb->reg.A ^= value;
+    flags_record(gb, FLAGS_OR, 0, 0, 0, gb->reg.A);
+}
+
+
+inline static void alu_or(gb_t *gb, uint8_t value)
+{
+    gb->reg.A |= value;
+    flags_record(gb, FLAGS_OR, 0, 0, 0, gb->reg.A);
+}
+
+
+inline static uint8_t alu_inc(gb_t *gb, uint8_t value)
+{
+    uint8_t result = value + 1;
+    flags_record(gb, FLAGS_INC, value, 1, flag_c(gb), result);
+    return result;
+}
+
+
+inline static uint8_t alu_dec(gb_t *gb, uint8_t value)
+{
+    uint8_t result = value - 1;
+    flags_record(gb, FLAGS_DEC, value, 1, flag_c(gb), result);
+    return result;
+}
+
+
+/* The remaining flag writers are rare enough to update F directly */
+static uint16_t alu_add_hl(gb_t *gb, uint16_t hl, uint16_t value)
+{
+    uint8_t f = flags_get(gb) & FLAG_Z;
+
+    if ((hl & 0x0FFF) + (value & 0x0FFF) > 0x0FFF)
+	f |= FLAG_H;
+    if ((uint32_t)hl + value > 0xFFFF)
+	f |= FLAG_C;
+    flags_set(gb, f);
+    return hl + value;
+}
+
+
+/* SP + e8, shared by ADD SP, e8 and LD HL, SP + e8 */
+static uint16_t alu_add_sp(gb_t *gb, int8_t offset)
+{
+    uint8_t value = (uint8_t)offset;
+    uint8_t f = 0;
+
+    if ((gb->reg.SP & 0x0F) + (value & 0x0F) > 0x0F)
+	f |= FLAG_H;
+    if ((gb->reg.SP & 0xFF) + value > 0xFF)
+	f |= FLAG_C;
+    flags_set(gb, f);
+    return gb->reg.SP + offset;
+}
+
+
+static void alu_daa(gb_t *gb)
+{
+    uint8_t f = flags_get(gb);
+    uint8_t a = gb->reg.A;
+    bool carry = f & FLAG_C;
+
+    if (f & FLAG_N)
+    {
+	if (f & FLAG_H)
+	    a -= 0x06;
+	if (carry)
+	    a -= 0x60;
+    }
+    else
+    {
+	if ((f & FLAG_H) || (a & 0x0F) > 0x09)
+	    a += 0x06;
+	if (carry || gb->reg.A > 0x99)
 	{
-	    return -EINVAL;
+	    a += 0x60;
+	    carry = true;
 	}
     }
-    return 0;
+    gb->reg.A = a;
+    flags_set(gb, (a == 0 ? FLAG_Z : 0) | (f & FLAG_N) | (carry ? FLAG_C : 0));
+}
+
+
+static void alu_cpl(gb_t *gb)
+{
+    gb->reg.A = ~gb->reg.A;
+    flags_set(gb, flags_get(gb) | FLAG_N | FLAG_H);
+}
+
+
+static void alu_scf(gb_t *gb)
+{
+    flags_set(gb, (flags_get(gb) & FLAG_Z) | FLAG_C);
+}
+
+
+static void alu_ccf(gb_t *gb)
+{
+    uint8_t f = flags_get(gb);
+    flags_set(gb, (f & FLAG_Z) | ((f & FLAG_C) ^ FLAG_C));
+}
+
+
+inline static void alu_rlca(gb_t *gb)
+{
+    uint8_t carry = gb->reg.A >> 7;
+    gb->reg.A = (gb->reg.A << 1) | carry;
+    flags_set(gb, carry ? FLAG_C : 0);
 }
 
 
-static int write_register(register_e registerType, uint16_t value)
+inline static void alu_rrca(gb_t *gb)
 {
-    switch(registerType) 
+    uint8_t carry = gb->reg.A & 1;
+    gb->reg.A = (gb->reg.A >> 1) | (carry << 7);
+    flags_set(gb, carry ? FLAG_C : 0);
+}
+
+
+inline static void alu_rla(gb_t *gb)
+{
+    uint8_t carry = gb->reg.A >> 7;
+    gb->reg.A = (gb->reg.A << 1) | flag_c(gb);
+    flags_set(gb, carry ? FLAG_C : 0);
+}
+
+
+inline static void alu_rra(gb_t *gb)
+{
+    uint8_t carry = gb->reg.A & 1;
+    gb->reg.A = (gb->reg.A >> 1) | (flag_c(gb) << 7);
+    flags_set(gb, carry ? FLAG_C : 0);
+}
+
+
+/* CB prefixed rotates and shifts, return the result */
+inline static uint8_t alu_rlc(gb_t *gb, uint8_t value)
+{
+    uint8_t result = (value << 1) | (value >> 7);
+    flags_record(gb, FLAGS_SHIFT, value, 0, value >> 7, result);
+    return result;
+}
+
+
+inline static uint8_t alu_rrc(gb_t *gb, uint8_t value)
+{
+    uint8_t result = (value >> 1) | (value << 7);
+    flags_record(gb, FLAGS_SHIFT, value, 0, value & 1, result);
+    return result;
+}
+
+
+inline static uint8_t alu_rl(gb_t *gb, uint8_t value)
+{
+    uint8_t result = (value << 1) | flag_c(gb);
+    flags_record(gb, FLAGS_SHIFT, value, 0, value >> 7, result);
+    return result;
+}
+
+
+inline static uint8_t alu_rr(gb_t *gb, uint8_t value)
+{
+    uint8_t result = (value >> 1) | (flag_c(gb) << 7);
+    flags_record(gb, FLAGS_SHIFT, value, 0, value & 1, result);
+    return result;
+}
+
+
+inline static uint8_t alu_sla(gb_t *gb, uint8_t value)
+{
+    uint8_t result = value << 1;
+    flags_record(gb, FLAGS_SHIFT, value, 0, value >> 7, result);
+    return result;
+}
+
+
+inline static uint8_t alu_sra(gb_t *gb, uint8_t value)
+{
+    uint8_t result = (value >> 1) | (value & 0x80);
+    flags_record(gb, FLAGS_SHIFT, value, 0, value & 1, result);
+    return result;
+}
+
+
+inline static uint8_t alu_swap(gb_t *gb, uint8_t value)
+{
+    uint8_t result = (value << 4) | (value >> 4);
+    flags_record(gb, FLAGS_SHIFT, value, 0, 0, result);
+    return result;
+}
+
+
+inline static uint8_t alu_srl(gb_t *gb, uint8_t value)
+{
+    uint8_t result = value >> 1;
+    flags_record(gb, FLAGS_SHIFT, value, 0, value & 1, result);
+    return result;
+}
+
+
+inline static void alu_bit(gb_t *gb, uint8_t bit, uint8_t value)
+{
+    flags_record(gb, FLAGS_BIT, value, bit, flag_c(gb), value & (1 << bit));
+}
+
+
+/* ======= STACK ======= */
+inline static void stack_push(gb_t *gb, uint16_t value)
+{
+    gb->reg.SP--;
+    bus_write(gb, gb->reg.SP, (uint8_t)(value >> 8));
+    gb->reg.SP--;
+    bus_write(gb, gb->reg.SP, (uint8_t)value);
+}
+
+
+inline static uint16_t stack_pop(gb_t *gb)
+{
+    uint16_t value = bus_read(gb, gb->reg.SP);
+    gb->reg.SP++;
+    value |= (uint16_t)bus_read(gb, gb->reg.SP) << 8;
+    gb->reg.SP++;
+    return value;
+}
+
+
+/*
+ * Execution trace, see trace.h. TRACE_BEGIN() notes the instruction about
+ * to run and TRACE_END() completes the record once it has, then either
+ * queues it for the binary trace file or prints it as a line of text.
+ * With TRACE_LEVEL set to TRACE_OFF both compile to nothing, so the
+ * execution loops make no formatting or stdio calls.
+ */
+#if TRACE_LEVEL > TRACE_OFF
+static void trace_begin(gb_t *gb, uint16_t pc, uint8_t opcode, uint16_t imm)
+{
+    gb->trace_pending.pc = pc;
+    gb->trace_pending.opcode = opcode;
+    gb->trace_pending.imm = imm;
+    gb->trace_pending.flags = 0;
+}
+
+
+static void trace_end(gb_t *gb)
+{
+    char line[128];
+
+    if (!gb->trace && !gb->trace_print)
+	return;
+
+    if (gb->trace || TRACE_LEVEL >= TRACE_FULL)
     {
-	case REGISTER_A:
-	{
-	    cpu.reg.A = (uint8_t)value;
-	} break;
-	case REGISTER_F:
-	{
-	    cpu.reg.F = (uint8_t)value;
-	} break;
-	case REGISTER_C:
+	gb->trace_pending.af = (uint16_t)gb->reg.A << 8 | flags_get(gb);
+	gb->trace_pending.bc = gb->reg.BC;
+	gb->trace_pending.de = gb->reg.DE;
+	gb->trace_pending.hl = gb->reg.HL;
+	gb->trace_pending.sp = gb->reg.SP;
+	gb->trace_pending.cycles = gb->cycles;
+    }
+
+    if (gb->trace)
+    {
+	trace_write(gb->trace, &gb->trace_pending);
+	return;
+    }
+
+    trace_format(line, sizeof(line), &gb->trace_pending, TRACE_LEVEL >= TRACE_FULL);
+    printf("%s\n", line);
+}
+
+#define TRACE_BEGIN(pc, opcode, imm) trace_begin(gb, pc, opcode, imm)
+#define TRACE_END() trace_end(gb)
+#else
+#define TRACE_BEGIN(pc, opcode, imm)
+#define TRACE_END()
+#endif
+
+
+/* Called by the handlers of instructions the CPU can't execute yet */
+static void cpu_unsupported(gb_t *gb)
+{
+#if TRACE_LEVEL > TRACE_OFF
+    gb->trace_pending.flags |= TRACE_RECORD_UNSUPPORTED;
+#else
+    fprintf(stderr, "ERROR: failed to execute instruction 0x%02X\n", gb->reg.IR);
+#endif
+}
+
+
+/* ======= INTERRUPTS ======= */
+
+/* EI, DI and RETI. Enabling interrupts may make one pending straight away. */
+inline static void cpu_set_ime(gb_t *gb, bool enable)
+{
+    gb->ime = enable;
+    if (enable)
+	scheduler_kick(&gb->scheduler);
+}
+
+
+static void cpu_halt(gb_t *gb)
+{
+    gb->halted = true;
+    scheduler_kick(&gb->scheduler);
+}
+
+
+/*
+ * Called between instructions once gb->cycles has reached scheduler.next.
+ * Runs the events that are due, then wakes the CPU from HALT and takes the
+ * highest priority interrupt if one is pending. A halted CPU jumps ahead
+ * to the next event instead of spinning until it. Returns true while the
+ * CPU stays halted.
+ */
+static bool cpu_service(gb_t *gb)
+{
+    uint8_t pending;
+
+    if (gb->halted)
+    {
+	uint64_t next = scheduler_earliest(&gb->scheduler);
+	if (next == SCHEDULER_NEVER)
+	    gb->cycles += 4;
+	else if (next > gb->cycles)
+	    gb->cycles = next;
+    }
+
+    scheduler_run(&gb->scheduler, gb->cycles);
+
+    pending = io_interrupts_pending(&gb->io);
+    if (pending)
+    {
+	gb->halted = false;
+	if (gb->ime)
 	{
-	    cpu.reg.C = (uint8_t)value;
-	} break;
-	case REGISTER_B:
+	    uint8_t n = 0;
+	    while (!(pending & (1 << n)))
+		n++;
+
+	    io_interrupt_ack(&gb->io, 1 << n);
+	    gb->ime = false;
+	    stack_push(gb, gb->reg.PC);
+	    gb->reg.PC = 0x0040 + 8 * n;
+	    gb->cycles += 20;
+	}
+    }
+
+    /* keep coming back here until something wakes the CPU */
+    if (gb->halted)
+	scheduler_kick(&gb->scheduler);
+    return gb->halted;
+}
+
+
+/* Only there to make the execution loops stop, see cpu_run_cycles() */
+static void run_end_event(void *context, uint64_t when)
+{
+}
+
+
+/* Specialised per-opcode handlers and the opcode_handlers[] dispatch table,
+ * generated from opcodes[] by tools/gen_handlers.c at build time. */
+#include "cpu_handlers.inc"
+
+
+/* ======= BLOCK CACHE ======= */
+
+/*
+ * Straight-line runs of instructions are decoded once into an array of
+ * micro-ops with their operand bytes already extracted and the PC delta
+ * taken from opcode_t.bytes. Blocks end after any instruction that can
+ * change the flow of control. block_t is declared with gb_t in gb.h.
+ *
+ * Blocks are found by start PC in a table of chains per 256-byte page of
+ * PC. A chain holds the blocks decoded at that PC from different memory,
+ * e.g. one per ROM bank, the one last run first. Each block is also on
+ * the list of every home page it has bytes in (at most two), so a write
+ * to a byte marked in code_bitmap only looks at the blocks of its page.
+ * Dropped blocks clear their bits in code_bitmap, except where another
+ * block still covers the byte, and are taken off the lists as they are
+ * next walked.
+ *
+ * OAM, the I/O registers and HRAM, from GB_IO_PAGE up, are written without
+ * the bus and so without dropping blocks, and code there is single stepped
+ * rather than decoded. No block runs into them either.
+ *
+ * Blocks are laid out one after the other in chunks of memory, only as
+ * many uops as they have. Once the chunks are full the whole cache starts
+ * over, which keeps stale code from piling up, and takes the native code
+ * with it. The cache is allocated the first time a block is decoded and
+ * freed with the instance.
+ */
+#define BLOCK_CHUNK_SIZE 0x40000
+#define BLOCK_CHUNKS     8
+
+/* Executions of a block before it is handed to the dynarec */
+#define DYNAREC_HOT_THRESHOLD 16
+
+struct block_cache_s {
+    block_t **by_pc[GB_PAGES];   /* 256 chains each, allocated on first use */
+    block_t *by_home[GB_PAGES];
+    uint8_t *chunks[BLOCK_CHUNKS];
+    size_t filled[BLOCK_CHUNKS]; /* bytes of blocks in each */
+    size_t chunk;                /* the one being filled */
+};
+
+
+static size_t block_size(size_t count)
+{
+    size_t size = sizeof(block_t) + count * sizeof(uop_t);
+
+    return (size + _Alignof(block_t) - 1) & ~(_Alignof(block_t) - 1);
+}
+
+
+/* The link to the next block on the list of home page `page` */
+static block_t **block_home_next(block_t *block, size_t page)
+{
+    return &block->next_home[(size_t)(block->home >> GB_PAGE_SHIFT) != page];
+}
+
+
+/* One past the block's last byte in its home pages */
+static uint32_t block_home_end(const block_t *block)
+{
+    return block->home + (block->end - block->start);
+}
+
+
+static void code_mark(gb_t *gb, uint32_t start, uint32_t end)
+{
+    for (uint32_t address = start; address < end; address++)
+    {
+	gb->code_bitmap[address >> 3] |= 1 << (address & 7);
+    }
+}
+
+
+static void code_clear(gb_t *gb, uint32_t start, uint32_t end)
+{
+    for (uint32_t address = start; address < end; address++)
+    {
+	gb->code_bitmap[address >> 3] &= ~(1 << (address & 7));
+    }
+}
+
+
+/* Drop every block decoded from a byte of [start, end) of the home pages */
+static void block_invalidate_range(gb_t *gb, uint16_t start, uint32_t end)
+{
+    block_cache_t *cache = gb->block_cache;
+    uint32_t low = end;
+    uint32_t high = start;
+
+    for (size_t page = start >> GB_PAGE_SHIFT; page << GB_PAGE_SHIFT < end; page++)
+    {
+	block_t **link = &cache->by_home[page];
+
+	while (*link)
 	{
-	    cpu.reg.B = (uint8_t)value;
-	} break;
-	case REGISTER_D:
+	    block_t *block = *link;
+	    block_t **next = block_home_next(block, page);
+
+	    if (block->valid && block->home < end && start < block_home_end(block))
+	    {
+		block->valid = false;
+		if (block->home < low)
+		    low = block->home;
+		if (block_home_end(block) > high)
+		    high = block_home_end(block);
+	    }
+	    if (!block->valid)
+		*link = *next;
+	    else
+		link = next;
+	}
+    }
+
+    /* the bytes of the blocks dropped stay code where others cover them */
+    if (low < high)
+    {
+	code_clear(gb, low, high);
+	for (size_t page = low >> GB_PAGE_SHIFT; page << GB_PAGE_SHIFT < high; page++)
 	{
-	    cpu.reg.D = (uint8_t)value;
-	} break;
-	case REGISTER_E:
+	    for (block_t *block = cache->by_home[page]; block;
+		 block = *block_home_next(block, page))
+	    {
+		uint32_t first = block->home > low ? block->home : low;
+		uint32_t last = block_home_end(block) < high ? block_home_end(block) : high;
+
+		if (block->valid)
+		    code_mark(gb, first, last);
+	    }
+	}
+    }
+    gb->block_generation++;
+}
+
+
+static void block_invalidate(gb_t *gb, uint16_t address)
+{
+    block_invalidate_range(gb, address, (uint32_t)address + 1);
+}
+
+
+/* Forget every block and the native code translated from them */
+static void block_cache_flush(gb_t *gb)
+{
+    block_cache_t *cache = gb->block_cache;
+
+    for (size_t page = 0; page < GB_PAGES; page++)
+    {
+	if (cache->by_pc[page])
+	    memset(cache->by_pc[page], 0, GB_PAGE_SIZE * sizeof(block_t *));
+    }
+    memset(cache->by_home, 0, sizeof(cache->by_home));
+    memset(cache->filled, 0, sizeof(cache->filled));
+    cache->chunk = 0;
+    memset(gb->code_bitmap, 0, sizeof(gb->code_bitmap));
+    if (gb->dynarec)
+	dynarec_flush(gb->dynarec);
+    gb->block_generation++;
+}
+
+
+static void block_cache_free(block_cache_t *cache)
+{
+    if (!cache)
+	return;
+    for (size_t page = 0; page < GB_PAGES; page++)
+    {
+	free(cache->by_pc[page]);
+    }
+    for (size_t i = 0; i < BLOCK_CHUNKS; i++)
+    {
+	free(cache->chunks[i]);
+    }
+    free(cache);
+}
+
+
+/* Drop the native code of every block, and count their hits from 0 again
+ * if `hits` */
+static void block_cache_native_reset(block_cache_t *cache, bool hits)
+{
+    for (size_t i = 0; cache && i <= cache->chunk; i++)
+    {
+	for (size_t offset = 0; offset < cache->filled[i];)
 	{
-	    cpu.reg.E = (uint8_t)value;
-	} break;
-	case REGISTER_H:
+	    block_t *block = (block_t *)&cache->chunks[i][offset];
+
+	    block->native = NULL;
+	    block->native_count = 0;
+	    if (hits)
+		block->hits = 0;
+	    offset += block_size(block->count);
+	}
+    }
+}
+
+
+/*
+ * Room for a block of BLOCK_MAX_UOPS at the end of the chunk being
+ * filled, the cache allocated and the chain of blocks at `pc` made ready
+ * as needed. The cache starts over when it is full. NULL if out of memory.
+ */
+static block_t *block_room(gb_t *gb, uint16_t pc)
+{
+    block_cache_t *cache = gb->block_cache;
+    size_t size = block_size(BLOCK_MAX_UOPS);
+
+    if (!cache && !(cache = gb->block_cache = calloc(1, sizeof(block_cache_t))))
+	return NULL;
+    if (cache->filled[cache->chunk] + size > BLOCK_CHUNK_SIZE)
+    {
+	if (cache->chunk + 1 < BLOCK_CHUNKS)
+	    cache->chunk++;
+	else
+	    block_cache_flush(gb);
+    }
+    if (!cache->chunks[cache->chunk] &&
+	!(cache->chunks[cache->chunk] = malloc(BLOCK_CHUNK_SIZE)))
+    {
+	/* make do with the chunks there are */
+	block_cache_flush(gb);
+	if (!cache->chunks[0])
+	    return NULL;
+    }
+    if (!cache->by_pc[pc >> GB_PAGE_SHIFT] &&
+	!(cache->by_pc[pc >> GB_PAGE_SHIFT] = calloc(GB_PAGE_SIZE, sizeof(block_t *))))
+	return NULL;
+    return (block_t *)&cache->chunks[cache->chunk][cache->filled[cache->chunk]];
+}
+
+
+/* Keep the block just decoded in room from block_room(): at the head of
+ * its chain and on the lists of its home pages */
+static void block_add(gb_t *gb, block_t *block)
+{
+    block_cache_t *cache = gb->block_cache;
+    block_t **chain = &cache->by_pc[block->start >> GB_PAGE_SHIFT][block->start & (GB_PAGE_SIZE - 1)];
+    size_t first = block->home >> GB_PAGE_SHIFT;
+    size_t last = (block_home_end(block) - 1) >> GB_PAGE_SHIFT;
+
+    cache->filled[cache->chunk] += block_size(block->count);
+    block->next = *chain;
+    *chain = block;
+    block->next_home[0] = cache->by_home[first];
+    cache->by_home[first] = block;
+    block->next_home[1] = NULL;
+    if (last != first)
+    {
+	block->next_home[1] = cache->by_home[last];
+	cache->by_home[last] = block;
+    }
+}
+
+
+/* Drop the blocks decoded from the bytes of the page at home address
+ * `start`, now `memory`, that `data` is about to change */
+static void page_code_load(gb_t *gb, size_t start, const uint8_t *memory, const uint8_t *data)
+{
+    uint64_t code[GB_PAGE_SIZE / 64];
+    size_t first = 0;
+    size_t end = GB_PAGE_SIZE;
+
+    memcpy(code, &gb->code_bitmap[start >> 3], sizeof(code));
+    if (!(code[0] | code[1] | code[2] | code[3]))
+	return;
+    while (first < end && memory[first] == data[first])
+	first++;
+    if (first == end)
+	return;
+    while (memory[end - 1] == data[end - 1])
+	end--;
+    for (size_t address = start + first; address < start + end; address++)
+    {
+	if (gb->code_bitmap[address >> 3] & (1 << (address & 7)))
 	{
-	    cpu.reg.H = (uint8_t)value;
-	} break;
-	case REGISTER_L:
+	    block_invalidate_range(gb, start + first, start + end);
+	    break;
+	}
+    }
+}
+
+
+/* cpu_page_load() of page `page` of cartridge RAM, which is seen every
+ * gb_cart_ram_span() pages of 0xA000-0xBFFF when its bank is mapped */
+static void cart_page_load(gb_t *gb, size_t page, const uint8_t *data)
+{
+    uint8_t *memory = &gb->cart_ram[page << GB_PAGE_SHIFT];
+    size_t span = gb_cart_ram_span(gb);
+
+    if (memcmp(memory, data, GB_PAGE_SIZE) == 0)
+	return;
+    for (size_t home = GB_CART_RAM_PAGE + page % span; home < GB_CART_RAM_PAGE + GB_CART_RAM_PAGES;
+	 home += span)
+    {
+	page_code_load(gb, home << GB_PAGE_SHIFT, memory, data);
+	gb->page_epoch[home] = gb->epoch;
+    }
+    memcpy(memory, data, GB_PAGE_SIZE);
+}
+
+
+/* Bits in r8[] of the registers an operand reads, memory operands
+ * included through the registers that form their address */
+static uint16_t operand_registers(operand_t *operand)
+{
+    switch(operand->type)
+    {
+	case OPERAND_TYPE_REGISTER_8BIT:
+	    return 1 << register_r8_index[operand->reg];
+	case OPERAND_TYPE_REGISTER_16BIT:
+	    return 3 << (2 * register_r16_index[operand->reg]);
+	default:
+	    return 0;
+    }
+}
+
+
+/*
+ * Registers an instruction reads and writes, for the instructions a
+ * polling loop is made of: loads into 8-bit registers, 8-bit compares and
+ * logic on A, BIT, NOP and jumps. Returns false for anything else,
+ * including every instruction that writes memory.
+ */
+static bool idle_instruction(uop_t *uop, uint16_t *reads, uint16_t *writes)
+{
+    opcode_t *opcode = uop->opcode == 0xCB ? opcode_cb_get((uint8_t)uop->imm)
+					   : opcode_get(uop->opcode);
+    operand_t *left = &opcode->op_left;
+    operand_t *right = &opcode->op_right;
+    uint16_t a = 1 << REG8_A, f = 1 << REG8_F;
+
+    switch(opcode->inst)
+    {
+	case INST_NOP:
 	{
-	    cpu.reg.L = (uint8_t)value;
-	} break;
-	case REGISTER_AF:
+	    *reads = *writes = 0;
+	    return opcode->bytes == 1;
+	}
+	case INST_LD:
+	case INST_LDH:
 	{
-	    cpu.reg.AF = value;
-	} break;
-	case REGISTER_HL:
+	    if (left->type != OPERAND_TYPE_REGISTER_8BIT || !left->immediate ||
+		right->type == OPERAND_TYPE_E8)
+		return false;
+	    *reads = operand_registers(right);
+	    *writes = operand_registers(left);
+	    return true;
+	}
+	case INST_ADD:
+	case INST_SUB:
+	case INST_AND:
+	case INST_OR:
+	case INST_XOR:
+	case INST_CP:
 	{
-	    cpu.reg.HL = value;
-	} break;
-	case REGISTER_BC:
+	    if (left->type != OPERAND_TYPE_REGISTER_8BIT)
+		return false;
+	    *reads = a | operand_registers(right);
+	    *writes = opcode->inst == INST_CP ? f : a | f;
+	    return true;
+	}
+	case INST_BIT:
 	{
-	    cpu.reg.BC = value;
-	} break;
-	case REGISTER_DE:
+	    /* C is passed through unchanged, so it doesn't count as a read */
+	    *reads = operand_registers(right);
+	    *writes = f;
+	    return true;
+	}
+	case INST_JR:
+	case INST_JP:
 	{
-	    cpu.reg.DE = value;
-	} break;
-	case REGISTER_SP:
+	    *reads = *writes = 0;
+	    return left->type != OPERAND_TYPE_REGISTER_16BIT;
+	}
+	case INST_JR_Z: case INST_JR_NZ: case INST_JR_C: case INST_JR_NC:
+	case INST_JP_Z: case INST_JP_NZ: case INST_JP_C: case INST_JP_NC:
 	{
-	    cpu.reg.SP = value;
-	} break;
+	    *reads = f;
+	    *writes = 0;
+	    return true;
+	}
 	default:
 	{
-	    return -EINVAL;
+	    return false;
 	}
     }
-    return 0;
 }
 
-inline static uint8_t read_byte_at_pc(bool immediate)
+
+/*
+ * A block is an idle loop when it branches back to its own start, writes
+ * no memory, and never reads a register before the body overwrites it.
+ * The last condition means every pass computes the same values, and so
+ * takes the same branch, for as long as memory doesn't change. Once the
+ * loop has gone round once, the rest of the wait can be skipped.
+ */
+static bool block_idle_loop(block_t *block)
 {
-    uint8_t byte;
+    uop_t *last = &block->uops[block->count - 1];
+    uint16_t read_first = 0, written = 0;
+    uint16_t target;
 
-    byte = cpu.RAM[cpu.reg.PC];
-    cpu.reg.PC++;
-    if (!immediate)
+    for (uop_t *uop = block->uops; uop <= last; uop++)
+    {
+	uint16_t reads, writes;
+
+	if (!idle_instruction(uop, &reads, &writes))
+	    return false;
+	read_first |= reads & ~written;
+	written |= writes;
+    }
+
+    switch(opcode_get(last->opcode)->op_left.type)
     {
-	byte = cpu.RAM[byte];
+	case OPERAND_TYPE_E8: target = block->end + (int8_t)last->imm; break;
+	case OPERAND_TYPE_A16: target = last->imm; break;
+	default: return false;
     }
 
-    return byte;
+    return target == block->start && !(read_first & written);
 }
 
 
-inline static uint16_t read_short_at_pc(bool immediate)
+/* Whether an instruction only touches registers: no memory, stack, I/O,
+ * interrupts or flow of control */
+static bool register_instruction(const uop_t *uop)
 {
-    /* first read the value at the program counter
-     * remembering that it is little endian*/
-    uint16_t value = (uint16_t)read_byte_at_pc(true);
-    value |= ((uint16_t)read_byte_at_pc(true) << 8);
+    const opcode_t *opcode = uop->opcode == 0xCB ? opcode_cb_get((uint8_t)uop->imm)
+						 : opcode_get(uop->opcode);
+    const operand_t *left = &opcode->op_left;
+    const operand_t *right = &opcode->op_right;
 
-    /* if this operand is not immediate, we must follow the pointer first */
-    if (!immediate)
+    if ((left->type != OPERAND_TYPE_UNKNOWN && !left->immediate) ||
+	(right->type != OPERAND_TYPE_UNKNOWN && !right->immediate))
+	return false;
+    switch(opcode->inst)
     {
-	value = cpu.RAM[value];
+	case INST_NOP: case INST_LD: case INST_INC: case INST_DEC:
+	case INST_ADD: case INST_ADC: case INST_SUB: case INST_SBC:
+	case INST_AND: case INST_XOR: case INST_OR: case INST_CP:
+	case INST_RLCA: case INST_RRCA: case INST_RLA: case INST_RRA:
+	case INST_DAA: case INST_CPL: case INST_SCF: case INST_CCF:
+	case INST_RLC: case INST_RRC: case INST_RL: case INST_RR:
+	case INST_SLA: case INST_SRA: case INST_SWAP: case INST_SRL:
+	case INST_BIT: case INST_RES: case INST_SET:
+	    return true;
+	default:
+	    return false;
     }
-
-    return value;
 }
 
 
-static int operand_get_value(operand_t *operand, uint16_t* value)
+static block_t *block_decode(gb_t *gb, uint16_t pc)
 {
-    switch(operand->type)
+    block_t *block;
+    uint32_t address = pc;
+
+    if (pc >= GB_IO_PAGE << GB_PAGE_SHIFT || !(block = block_room(gb, pc)))
+	return NULL;
+    block->start = pc;
+    block->home = gb_home(gb, pc);
+    block->source[0] = gb->bus[pc >> GB_PAGE_SHIFT].read;
+    block->count = 0;
+    block->hits = 0;
+    block->native = NULL;
+    block->native_count = 0;
+    while (block->count < BLOCK_MAX_UOPS)
     {
-	case OPERAND_TYPE_REGISTER_8BIT:
-	case OPERAND_TYPE_REGISTER_16BIT:
-	{
-	    read_register(operand->reg, value);
-	    if (operand->immediate)
-		printf("%s", register_to_string(operand->reg));
-	    else
-		printf("[%s]", register_to_string(operand->reg));
-	} break;  
+	uint8_t opcode = gb_peek(gb, address);
+	uint8_t length = opcode_lengths[opcode];
+	uop_t *uop = &block->uops[block->count];
 
-	case OPERAND_TYPE_N8:
-	case OPERAND_TYPE_E8:
+	if (address + length > GB_IO_PAGE << GB_PAGE_SHIFT)
 	{
-	    if (!operand->immediate)
-	    {
-		/* 8bit values must be immediate */
-		return -EINVAL;
-	    }
-	   *value = read_byte_at_pc(operand->immediate);
-	    printf("0x%02X", *value);
-	} break;
-
-	case OPERAND_TYPE_N16:
-	case OPERAND_TYPE_A16:
+	    /* don't decode into OAM and the I/O page, see above */
+	    break;
+	}
+	if (block->count > 0 && gb_home(gb, address + length - 1) !=
+	    (uint16_t)(block->home + (address + length - 1 - pc)))
 	{
-	    *value = read_short_at_pc(operand->immediate);
-	    if (operand->immediate)
-		printf("0x%04X", *value);
-	    else
-		printf("[0x%04X]", *value);
-	    
-	} break;             
+	    /* nor into pages whose home doesn't follow on, so the block's
+	     * bytes stay one range of home addresses */
+	    break;
+	}
 
-	case OPERAND_TYPE_A8:
+	uop->handler = opcode_handlers[opcode];
+	uop->opcode = opcode;
+	uop->length = length;
+	uop->cycles = opcode_cycles[opcode];
+	uop->imm = 0;
+	if (length > 1)
+	    uop->imm = gb_peek(gb, address + 1);
+	if (length > 2)
+	    uop->imm |= (uint16_t)gb_peek(gb, address + 2) << 8;
+	if (opcode == 0xCB)
 	{
-	    uint8_t HRAM_offset; 
-	    HRAM_offset = read_byte_at_pc(operand->immediate);
-	    *value = 0xFF00 + HRAM_offset;
-	    printf("0x%02X", *value);
-	} break;             
+	    /* resolve the second level now so the uop calls it directly */
+	    uop->handler = cb_handlers[uop->imm];
+	    uop->cycles += cb_cycles[uop->imm];
+	}
 
-	default:
+	for (uint32_t i = address; i < address + length; i++)
 	{
-	    /* invalid operand type */
-	    return -EINVAL;
+	    uint16_t home = gb_home(gb, i);
+
+	    gb->code_bitmap[home >> 3] |= 1 << (home & 7);
 	}
+
+	address += length;
+	block->count++;
+	if (opcode_ends_block[opcode])
+	    break;
     }
-    return 0;
+    block->end = address;
+    block->source[1] = gb->bus[(address - 1) >> GB_PAGE_SHIFT].read;
+    block->valid = block->count > 0;
+    if (!block->valid)
+	return NULL;
+    block->idle = block_idle_loop(block);
+    block->prefix = 0;
+    block->prefix_cycles = 0;
+    while (block->prefix + 1 < block->count && register_instruction(&block->uops[block->prefix]))
+	block->prefix_cycles += block->uops[block->prefix++].cycles;
+    block_add(gb, block);
+
+    return block;
 }
 
-static int handle_add(operand_t *left, operand_t *right)
+
+/* First cycle at which something other than the CPU could change what an
+ * idle loop that started a pass at `since` is polling: the next scheduled
+ * event, or a tick of DIV or TIMA if the loop reads them. */
+static uint64_t idle_deadline(gb_t *gb, uint64_t since)
 {
-    uint16_t src;
-    uint16_t dst;
+    uint64_t deadline = io_idle_deadline(&gb->io, since, gb->cycles);
 
-    if (!(left->type == OPERAND_TYPE_REGISTER_8BIT ||
-	  left->type == OPERAND_TYPE_REGISTER_16BIT))
-    {
-	printf("%s: SOMETHING HAS GONE WRONG", __FUNCTION__);
-	/* first operand must be a register */
-	return -EINVAL;
-    }
+    return gb->scheduler.next < deadline ? gb->scheduler.next : deadline;
+}
+
+
+/*
+ * Called once an idle loop has gone round a full pass taking
+ * `pass_cycles`. Charges the cycles of the passes that would run before
+ * the deadline or the end of the `count` instruction budget, without
+ * running them. Returns the number of instructions skipped.
+ */
+static size_t block_idle_skip(gb_t *gb, block_t *block, uint64_t pass_cycles, size_t count)
+{
+    uint64_t deadline = idle_deadline(gb, gb->cycles - pass_cycles);
+    uint64_t passes = count / block->count;
+
+    if (deadline <= gb->cycles || pass_cycles == 0)
+	return 0;
+    if (passes > (deadline - gb->cycles) / pass_cycles)
+	passes = (deadline - gb->cycles) / pass_cycles;
 
-    operand_get_value(left, &dst);
-    printf(", ");
-    operand_get_value(right, &src);
-    //printf("operand_get_value: 0x%04X\n", src);
-    write_register(left->reg, dst + src);
-    //printf("write_register: 0x%04X into %s\n", left->reg + src, register_to_string(left->reg));
-    return 0;
+    gb->cycles += passes * pass_cycles;
+    return passes * block->count;
 }
 
 
-static int handle_ld(operand_t *left, operand_t *right)
+static void block_compile(gb_t *gb, block_t *block)
 {
-    uint16_t src;
+    uint8_t code[BLOCK_MAX_UOPS * 3];
+    size_t length = 0;
 
-    if (!(left->type == OPERAND_TYPE_REGISTER_8BIT ||
-	  left->type == OPERAND_TYPE_REGISTER_16BIT))
+    /* translate the bytes the block was decoded from and no further, so
+     * the block's invalidation also covers its native code */
+    for (size_t i = 0; i < block->count; i++)
     {
-	printf("%s: SOMETHING HAS GONE WRONG", __FUNCTION__);
-	/* first operand must be a register */
-	return -EINVAL;
-    }
+	const uop_t *uop = &block->uops[i];
 
+	code[length++] = uop->opcode;
+	if (uop->length > 1)
+	    code[length++] = (uint8_t)uop->imm;
+	if (uop->length > 2)
+	    code[length++] = (uint8_t)(uop->imm >> 8);
+    }
+    block->native = dynarec_compile(gb->dynarec, code, block->start, block->count,
+				    &block->native_count);
+    if (!block->native && block->native_count)
+    {
+	/* out of code space: drop every translation and start over */
+	block_cache_native_reset(gb->block_cache, false);
+	dynarec_flush(gb->dynarec);
+	block->native = dynarec_compile(gb->dynarec, code, block->start, block->count,
+				    &block->native_count);
+    }
 
-    if (left->immediate)
+    block->native_cycles = 0;
+    for (size_t i = 0; i < block->native_count; i++)
     {
-	printf("%s, ", register_to_string(left->reg));
-	operand_get_value(right, &src);
-	write_register(left->reg, src);
+	uint8_t opcode = block->uops[i].opcode;
+
+	block->native_cycles += block->uops[i].cycles;
+	/* JR cc and JP cc take an M-cycle more when they branch */
+	if ((opcode & 0xE7) == 0x20 || (opcode & 0xE7) == 0xC2)
+	    block->native_cycles += 4;
     }
-    else
+}
+
+
+/* Whether the pages the block was decoded from still hold the same
+ * memory, rather than say another bank of ROM */
+inline static bool block_mapped(const gb_t *gb, const block_t *block)
+{
+    return gb->bus[block->start >> GB_PAGE_SHIFT].read == block->source[0] &&
+	   gb->bus[(block->end - 1) >> GB_PAGE_SHIFT].read == block->source[1];
+}
+
+
+/* block_lookup() past the head of the chain at `pc`: dead blocks are
+ * taken off it, and a block found further down moves to the head */
+static block_t *block_chain_lookup(gb_t *gb, uint16_t pc)
+{
+    block_t **chains = gb->block_cache->by_pc[pc >> GB_PAGE_SHIFT];
+    block_t **head = &chains[pc & (GB_PAGE_SIZE - 1)];
+    block_t **link = head;
+
+    while (*link)
     {
-	uint16_t dst;
-	read_register(left->reg, &dst);
-	printf("[%s], ", register_to_string(left->reg));
-	operand_get_value(right, &src);
-	cpu.RAM[dst] = src;
+	block_t *block = *link;
+
+	if (!block->valid)
+	{
+	    *link = block->next;
+	    continue;
+	}
+	if (block_mapped(gb, block))
+	{
+	    *link = block->next;
+	    block->next = *head;
+	    *head = block;
+	    return block;
+	}
+	link = &block->next;
     }
-    return 0;
+    return block_decode(gb, pc);
+}
+
+
+inline static block_t *block_lookup(gb_t *gb, uint16_t pc)
+{
+    block_t **chains;
+    block_t *block;
+
+    if (!gb->block_cache || !(chains = gb->block_cache->by_pc[pc >> GB_PAGE_SHIFT]))
+	return block_decode(gb, pc);
+    block = chains[pc & (GB_PAGE_SIZE - 1)];
+    if (block && block->valid && block_mapped(gb, block))
+	return block;
+    return block_chain_lookup(gb, pc);
 }
 
 /* ======= PRIVATE FUNCTIONS ======= */
-void cpu_print_state()
+void cpu_print_state(gb_t *gb)
 {
+    flags_materialize(gb);
     printf("CPU STATE:\n");
     printf("PC: 0x%04X SP: 0x%04X IR: 0x%04X\n",
-	    cpu.reg.PC, cpu.reg.SP, cpu.reg.IR);
+	    gb->reg.PC, gb->reg.SP, gb->reg.IR);
+    printf("CYCLES: %llu\n", (unsigned long long)gb->cycles);
     printf("A: 0x%02X	B: 0x%02X D: 0x%02X H: 0x%02X\n",
-	    cpu.reg.A, cpu.reg.B,cpu.reg.D, cpu.reg.H);
+	    gb->reg.A, gb->reg.B,gb->reg.D, gb->reg.H);
     printf("F: 0x%02X C: 0x%02X E: 0x%02X L: 0x%02X\n",
-	    cpu.reg.F, cpu.reg.C,cpu.reg.E,cpu.reg.L);
+	    gb->reg.F, gb->reg.C,gb->reg.E,gb->reg.L);
 
     printf("RAM:\n\t"); 
     for (uint16_t i = 0x0; i <= 0xF; i++)
@@ -346,60 +1375,569 @@ void cpu_print_state()
 	{
 	    printf("\n%04X\t", i); 
 	}
-	printf("%02X ", cpu.RAM[i]);
+	printf("%02X ", gb_peek(gb, i));
     }
     printf("\n"); 
 
 }
 
 
-void cpu_init() 
+/*
+ * FNV-1a hash of the registers, cycle count and memory, for telling at a
+ * glance whether two runs ended in the same state.
+ */
+uint64_t cpu_state_hash(gb_t *gb)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    uint8_t state[14];
+
+    flags_materialize(gb);
+    state[0] = gb->reg.A;
+    state[1] = gb->reg.F;
+    state[2] = gb->reg.B;
+    state[3] = gb->reg.C;
+    state[4] = gb->reg.D;
+    state[5] = gb->reg.E;
+    state[6] = gb->reg.H;
+    state[7] = gb->reg.L;
+    state[8] = gb->reg.SP >> 8;
+    state[9] = gb->reg.SP & 0xFF;
+    state[10] = gb->reg.PC >> 8;
+    state[11] = gb->reg.PC & 0xFF;
+    state[12] = gb->ime;
+    state[13] = gb->halted;
+
+    for (size_t i = 0; i < sizeof(state); i++)
+    {
+	hash = (hash ^ state[i]) * 0x100000001B3ULL;
+    }
+    for (int i = 0; i < 64; i += 8)
+    {
+	hash = (hash ^ (uint8_t)(gb->cycles >> i)) * 0x100000001B3ULL;
+    }
+    for (size_t page = 0; page < GB_PAGES; page++)
+    {
+	const uint8_t *memory = &gb->RAM[page << GB_PAGE_SHIFT];
+	const uint8_t *read = gb->bus[page].read;
+
+	/* pages mapped from outside RAM[], the cartridge's, from there */
+	if (read && (read < gb->RAM || read >= gb->RAM + sizeof(gb->RAM)))
+	    memory = read;
+	for (size_t i = 0; i < GB_PAGE_SIZE; i++)
+	{
+	    hash = (hash ^ memory[i]) * 0x100000001B3ULL;
+	}
+    }
+    return hash;
+}
+
+
+/* A new instance, already through cpu_init(). NULL if out of memory. */
+gb_t *gb_alloc()
 {
-    cpu.reg.PC = 0x0000;
-    cpu.RAM[0x0000] = 0x3E;
-    cpu.RAM[0x0001] = 0x69; 
-    cpu.RAM[0x0002] = 0x01;
-    cpu.RAM[0x0003] = 0x08; 
-    cpu.RAM[0x0004] = 0x00;
-    cpu.RAM[0x0005] = 0x02;
-    cpu.RAM[0x0006] = 0x00;
-    cpu.RAM[0x0007] = 0x00;
-    cpu.RAM[0x0008] = 0x00;
+    gb_t *gb = calloc(1, sizeof(gb_t));
+
+    if (gb)
+	cpu_init(gb);
+    return gb;
 }
 
 
-void cpu_fetch()
+/* Free an instance, finishing its binary trace if one is open */
+void gb_free(gb_t *gb)
 {
-    cpu.reg.IR = cpu.RAM[cpu.reg.PC];
-    cpu.reg.PC++;
+    if (!gb)
+	return;
+    if (gb->trace)
+	trace_close(gb->trace);
+    dynarec_destroy(gb->dynarec);
+    cart_eject(gb);
+    block_cache_free(gb->block_cache);
+    free(gb);
 }
 
 
-void cpu_execute()
+void cpu_init(gb_t *gb) 
 {
-    opcode_t *opcode = opcode_get(cpu.reg.IR);
+    gb->idle_skip = true;
+    gb->trace_print = true;
+    gb->halted = false;
+    scheduler_init(&gb->scheduler);
+    bus_reset(gb);
+    bus_map_handlers(gb, GB_PAGES - 1, 1, io_page_read, io_page_write);
+    bus_map_handlers(gb, PPU_TILE_DATA >> GB_PAGE_SHIFT,
+		     (PPU_TILE_DATA_END - PPU_TILE_DATA) >> GB_PAGE_SHIFT, NULL, tile_data_write);
+    ppu_reset(&gb->ppu);
+    io_reset(&gb->io, &gb->scheduler, gb->RAM, gb->bus, &gb->ppu, gb->cycles);
+    scheduler_register(&gb->scheduler, EVENT_RUN_END, run_end_event, gb);
+    gb->reg.PC = 0x0000;
+    gb->RAM[0x0000] = 0x3E;
+    gb->RAM[0x0001] = 0x69; 
+    gb->RAM[0x0002] = 0x01;
+    gb->RAM[0x0003] = 0x08; 
+    gb->RAM[0x0004] = 0x00;
+    gb->RAM[0x0005] = 0x02;
+    gb->RAM[0x0006] = 0x00;
+    gb->RAM[0x0007] = 0x00;
+    gb->RAM[0x0008] = 0x00;
+    gb_pages_written(gb, 0x0000, 0x0009);
+}
 
-    printf("[0x%04X] %s ",
-	    cpu.reg.PC - 1,
-	    instruction_to_string(opcode->inst));
 
-    switch(opcode->inst)
+/* Enable or disable the dynarec, returns false if it isn't available */
+bool cpu_set_dynarec(gb_t *gb, bool enable)
+{
+    if (enable && !gb->dynarec)
     {
-	case INST_NOP:
+	gb->dynarec = dynarec_create();
+	if (!gb->dynarec)
+	    return false;
+    }
+    else if (!enable)
+    {
+	dynarec_destroy(gb->dynarec);
+	gb->dynarec = NULL;
+    }
+
+    block_cache_native_reset(gb->block_cache, true);
+    if (gb->dynarec)
+	dynarec_flush(gb->dynarec);
+    return true;
+}
+
+
+/*
+ * Record the trace to `path` in binary instead of printing it, see trace.h.
+ * Returns false if the file can't be opened or tracing is compiled out.
+ */
+bool cpu_trace_start(gb_t *gb, const char *path, bool drop_on_overflow)
+{
+#if TRACE_LEVEL > TRACE_OFF
+    if (gb->trace)
+	return false;
+    gb->trace = trace_open(path, TRACE_RING_DEFAULT_RECORDS,
+			   drop_on_overflow ? TRACE_OVERFLOW_DROP
+					    : TRACE_OVERFLOW_BLOCK);
+    return gb->trace != NULL;
+#else
+    return false;
+#endif
+}
+
+
+/* Finish the binary trace, returns the number of records dropped */
+uint64_t cpu_trace_stop(gb_t *gb)
+{
+    uint64_t dropped;
+
+    if (!gb->trace)
+	return 0;
+    dropped = trace_close(gb->trace);
+    gb->trace = NULL;
+    return dropped;
+}
+
+
+/* Print the text trace or not, on after cpu_init(). No effect on a binary
+ * trace being recorded, or with TRACE_LEVEL set to TRACE_OFF. */
+void cpu_set_trace_print(gb_t *gb, bool enable)
+{
+    gb->trace_print = enable;
+}
+
+
+/* Enable or disable fast-forwarding idle loops, on after cpu_init() */
+void cpu_set_idle_skip(gb_t *gb, bool enable)
+{
+    gb->idle_skip = enable;
+}
+
+
+/* Services events and interrupts first, fetches nothing while halted */
+void cpu_fetch(gb_t *gb)
+{
+    if (gb->cycles >= gb->scheduler.next && cpu_service(gb))
+	return;
+    gb->reg.IR = gb_peek(gb, gb->reg.PC);
+    gb->reg.PC++;
+}
+
+
+void cpu_execute(gb_t *gb)
+{
+    uint16_t imm;
+
+    if (gb->halted)
+	return;
+
+    imm = read_operand(gb, opcode_lengths[gb->reg.IR]);
+
+    gb->cycles += opcode_cycles[gb->reg.IR];
+    TRACE_BEGIN(gb->reg.PC - opcode_lengths[gb->reg.IR], gb->reg.IR, imm);
+    opcode_handlers[gb->reg.IR](gb, imm);
+    TRACE_END();
+}
+
+
+/*
+ * Fetch and dispatch `count` instructions without returning to the caller.
+ * Scheduled events and interrupts are serviced between instructions.
+ *
+ * With GCC labels-as-values (and unless built with -DCPU_DISPATCH_SWITCH)
+ * every handler gets its own copy of the fetch and indirect jump, so the
+ * branch predictor sees one dispatch site per opcode. Other compilers get
+ * a plain switch inside the loop.
+ */
+#if defined(__GNUC__) && !defined(CPU_DISPATCH_SWITCH)
+#define CPU_DISPATCH_THREADED
+#endif
+
+void cpu_run(gb_t *gb, size_t count)
+{
+#ifdef CPU_DISPATCH_THREADED
+#define OPCODE_LABEL(op, len) [0x##op] = &&do_op_##op,
+#define OPCODE_BODY(op, len)						\
+    do_op_##op:								\
+    {									\
+	uint16_t imm = read_operand(gb, len);				\
+	TRACE_BEGIN(gb->reg.PC - len, 0x##op, imm);			\
+	op_##op(gb, imm);							\
+	TRACE_END();							\
+    }									\
+    DISPATCH();
+#define DISPATCH()						\
+    do {							\
+	if (count-- == 0)					\
+	    return;						\
+	if (gb->cycles >= gb->scheduler.next && cpu_service(gb)) \
+	    goto halted;					\
+	gb->reg.IR = gb_peek(gb, gb->reg.PC);			\
+	gb->cycles += opcode_cycles[gb->reg.IR];		\
+	gb->reg.PC++;						\
+	goto *dispatch[gb->reg.IR];				\
+    } while (0)
+
+#define CB_LABEL(op) [0x##op] = &&do_cb_##op,
+#define CB_BODY(op) do_cb_##op: cb_##op(gb, 0); TRACE_END(); DISPATCH();
+
+    static void *dispatch[OPCODE_COUNT] =
+    {
+	OPCODE_LIST(OPCODE_LABEL)
+	[0xCB] = &&do_prefix_cb,
+    };
+    static void *cb_dispatch[OPCODE_COUNT] = { CB_OPCODE_LIST(CB_LABEL) };
+
+    /* while halted each pass through here uses up one of `count` */
+    halted:
+    DISPATCH();
+    OPCODE_LIST(OPCODE_BODY)
+
+    /* second level, jumps straight to the CB instruction's handler */
+    do_prefix_cb:
+    {
+	uint8_t cb = read_byte_at_pc(gb, true);
+	TRACE_BEGIN(gb->reg.PC - 2, 0xCB, cb);
+	gb->cycles += cb_cycles[cb];
+	goto *cb_dispatch[cb];
+    }
+    CB_OPCODE_LIST(CB_BODY)
+
+#undef CB_BODY
+#undef CB_LABEL
+#undef DISPATCH
+#undef OPCODE_BODY
+#undef OPCODE_LABEL
+#else
+#define OPCODE_CASE(op, len)						\
+    case 0x##op:							\
+    {									\
+	uint16_t imm = read_operand(gb, len);				\
+	TRACE_BEGIN(gb->reg.PC - len, 0x##op, imm);			\
+	op_##op(gb, imm);							\
+    } break;
+#define CB_CASE(op) case 0x##op: cb_##op(gb, 0); break;
+
+    while (count--)
+    {
+	if (gb->cycles >= gb->scheduler.next && cpu_service(gb))
+	    continue;
+	gb->reg.IR = gb_peek(gb, gb->reg.PC);
+	gb->reg.PC++;
+	gb->cycles += opcode_cycles[gb->reg.IR];
+	switch(gb->reg.IR)
 	{
-	    /* Do nothing with NOP instruction */
-	} break;
-	case INST_LD:
+	    OPCODE_LIST(OPCODE_CASE)
+	    case 0xCB:
+	    {
+		uint8_t cb = read_byte_at_pc(gb, true);
+		TRACE_BEGIN(gb->reg.PC - 2, 0xCB, cb);
+		gb->cycles += cb_cycles[cb];
+		switch(cb)
+		{
+		    CB_OPCODE_LIST(CB_CASE)
+		}
+	    } break;
+	}
+	TRACE_END();
+    }
+
+#undef CB_CASE
+#undef OPCODE_CASE
+#endif
+}
+
+
+/*
+ * Run up to `count` instructions from the block cache, stopping early at
+ * the first instruction boundary at or after cycle `until`. Blocks are
+ * decoded on first use, with single stepping where no block can be
+ * decoded. With the dynarec enabled, blocks that get hot run as native
+ * code for as long as it covers them and the interpreter runs the rest of
+ * the block.
+ */
+static void run_blocks(gb_t *gb, size_t count, uint64_t until)
+{
+    /* the rest of the block an event stopped, and the PC it goes on at */
+    block_t *stopped = NULL;
+    uop_t *resume = NULL;
+    uint16_t resume_pc = 0;
+    uint32_t generation = gb->block_generation;
+
+    while (count && gb->cycles < until)
+    {
+	uint64_t start_cycles = gb->cycles;
+	block_t *block;
+	uop_t *uop;
+	bool whole = true; /* run from its start */
+
+	if (gb->cycles >= gb->scheduler.next)
 	{
-	    handle_ld(&opcode->op_left, &opcode->op_right);
-	} break;
-	case INST_ADD:
+	    if (cpu_service(gb))
+	    {
+		stopped = NULL;
+		count--;
+		continue;
+	    }
+	    if (gb->cycles >= until)
+	    {
+		/* woken from HALT, or sent to an interrupt, past the end */
+		break;
+	    }
+	}
+
+	if (stopped && gb->reg.PC == resume_pc && gb->block_generation == generation)
 	{
-	    handle_add(&opcode->op_left, &opcode->op_right);
-	} break;
-	default:
-	    printf("ERROR: failed to execute instruction");
+	    /* no code was written or remapped meanwhile, so rather than
+	     * decode a block from the middle of this one, finish it */
+	    block = stopped;
+	    uop = resume;
+	    stopped = NULL;
+	    whole = false;
+	}
+	else
+	{
+	    block = block_lookup(gb, gb->reg.PC);
+	    generation = gb->block_generation;
+	    stopped = NULL;
+
+	    if (!block)
+	    {
+		cpu_fetch(gb);
+		cpu_execute(gb);
+		count--;
+		continue;
+	    }
+
+	    if (gb->dynarec && !block->native && block->hits < DYNAREC_HOT_THRESHOLD &&
+		++block->hits == DYNAREC_HOT_THRESHOLD)
+	    {
+		block_compile(gb, block);
+	    }
+	    uop = block->uops;
+	    if (block->native && count >= block->native_count &&
+		gb->cycles + block->native_cycles < gb->scheduler.next)
+	    {
+		/* native code isn't traced and can't stop part way, so it only
+		 * runs when no event falls due before it ends. It works on F
+		 * itself. The rest of the block goes on from where it stops. */
+		flags_materialize(gb);
+		gb->cycles += block->native(&gb->reg);
+		count -= block->native_count;
+		uop += block->native_count;
+	    }
+	    else if (block->prefix && count > block->prefix &&
+		gb->cycles + block->prefix_cycles < gb->scheduler.next)
+	    {
+		/* the prefix touches nothing but registers, so it can't
+		 * rewrite code or bring an event forward, and none falls due
+		 * during it */
+		for (; uop < block->uops + block->prefix; uop++)
+		{
+		    gb->reg.IR = uop->opcode;
+		    TRACE_BEGIN(gb->reg.PC, uop->opcode, uop->imm);
+		    gb->reg.PC += uop->length;
+		    gb->cycles += uop->cycles;
+		    uop->handler(gb, uop->imm);
+		    TRACE_END();
+		}
+		count -= block->prefix;
+	    }
+	}
+
+	for (; uop < block->uops + block->count && count; uop++)
+	{
+	    gb->reg.IR = uop->opcode;
+	    TRACE_BEGIN(gb->reg.PC, uop->opcode, uop->imm);
+	    gb->reg.PC += uop->length;
+	    gb->cycles += uop->cycles;
+	    uop->handler(gb, uop->imm);
+	    TRACE_END();
+	    count--;
+
+	    if (gb->block_generation != generation)
+	    {
+		/* the block may have rewritten itself */
+		break;
+	    }
+	    if (gb->cycles >= gb->scheduler.next)
+	    {
+		/* an event or interrupt is due before the next instruction */
+		stopped = block;
+		resume = uop + 1;
+		resume_pc = gb->reg.PC;
+		break;
+	    }
+	}
+
+	if (block->idle && gb->idle_skip && whole && gb->reg.PC == block->start &&
+	    uop == block->uops + block->count)
+	{
+	    /* skipped passes aren't traced */
+	    count -= block_idle_skip(gb, block, gb->cycles - start_cycles, count);
+	}
+	if (stopped && resume == block->uops + block->count)
+	    stopped = NULL;
+    }
+}
+
+
+/* Run `count` instructions from the block cache, see run_blocks() */
+void cpu_run_cached(gb_t *gb, size_t count)
+{
+    run_blocks(gb, count, SCHEDULER_NEVER);
+}
+
+
+/*
+ * Run for at least `cycles` clock cycles and return the number actually
+ * run. The budget is an event of its own, so the loops stop on it with
+ * the check they already make for every other event, and idle loops and
+ * HALT fast-forward up to it. It can be overshot by the last instruction,
+ * or an interrupt taken just before the end.
+ */
+uint64_t cpu_run_cycles(gb_t *gb, uint64_t cycles)
+{
+    uint64_t start = gb->cycles;
+
+    if (cycles == 0)
+	return 0;
+
+    scheduler_schedule(&gb->scheduler, EVENT_RUN_END, start + cycles);
+    run_blocks(gb, SIZE_MAX, start + cycles);
+    cpu_run_finish(gb);
+
+    return gb->cycles - start;
+}
+
+
+/* The end of cpu_run_cycles(), once the loops have reached the budget */
+void cpu_run_finish(gb_t *gb)
+{
+    scheduler_cancel(&gb->scheduler, EVENT_RUN_END);
+    if (gb->cycles >= gb->scheduler.next)
+    {
+	/* run what is due so state read between runs is up to date, and
+	 * leave interrupts for the next run to take */
+	scheduler_run(&gb->scheduler, gb->cycles);
+	scheduler_kick(&gb->scheduler);
+    }
+}
+
+
+/*
+ * One pass of run_blocks(): the block at PC, or a single instruction where
+ * no block can be decoded, stopping early at `until` as usual. An idle
+ * loop runs on up to the next event instead, so it still gets skipped.
+ */
+void cpu_run_block(gb_t *gb, uint64_t until)
+{
+    block_t *block = block_lookup(gb, gb->reg.PC);
+
+    if (block && block->idle && gb->idle_skip && gb->cycles < gb->scheduler.next)
+    {
+	run_blocks(gb, SIZE_MAX, gb->scheduler.next < until ? gb->scheduler.next : until);
+	return;
+    }
+    run_blocks(gb, block ? block->count : 1, until);
+}
+
+
+/* cpu_service() for other runners, called once an event is due */
+bool cpu_service_events(gb_t *gb)
+{
+    return cpu_service(gb);
+}
+
+
+/* The cached block starting at `pc`, decoded if need be. NULL if there is
+ * no block to be had there. */
+block_t *cpu_block_at(gb_t *gb, uint16_t pc)
+{
+    return block_lookup(gb, pc);
+}
 
+
+/* Bring F up to date, leaving no flags pending */
+void cpu_flags_flush(gb_t *gb)
+{
+    flags_materialize(gb);
+}
+
+
+/*
+ * Replace a page of the state from outside the bus, e.g. to put saved state
+ * back: of RAM, or from GB_PAGES on of cartridge RAM. Blocks decoded from
+ * bytes that change are dropped, tiles in it are decoded again, and the
+ * page is stamped with the current write epoch.
+ */
+void cpu_page_load(gb_t *gb, size_t page, const uint8_t *data)
+{
+    size_t start = page << GB_PAGE_SHIFT;
+
+    if (page >= GB_PAGES)
+    {
+	cart_page_load(gb, page - GB_PAGES, data);
+	return;
     }
-    printf("\n");
+    ppu_tiles_stale(&gb->ppu, start, start + GB_PAGE_SIZE);
+    page_code_load(gb, start, &gb->RAM[start], data);
+    memcpy(&gb->RAM[start], data, GB_PAGE_SIZE);
+    gb->page_epoch[page] = gb->epoch;
+}
+
+
+/*
+ * Called when pages of the page table change. The blocks decoded from
+ * them are found out at lookup, see block_mapped(), so this only stops a
+ * running block, which may have switched out its own code.
+ */
+void cpu_pages_remapped(gb_t *gb)
+{
+    gb->block_generation++;
+}
+
+
+uint64_t cpu_cycles(gb_t *gb)
+{
+    return gb->cycles;
 }
@@ -1,9 +1,30 @@
 #ifndef __CPU_H__
 #define __CPU_H__
 
-void cpu_init();
-void cpu_fetch();
-void cpu_execute();
-void cpu_print_state();
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* An emulator instance. Opaque, every function takes the instance it
+ * works on and instances share no mutable state. */
+typedef struct gb_s gb_t;
+
+gb_t *gb_alloc();
+void gb_free(gb_t *gb);
+
+void cpu_init(gb_t *gb);
+void cpu_fetch(gb_t *gb);
+void cpu_execute(gb_t *gb);
+void cpu_run(gb_t *gb, size_t count);
+void cpu_run_cached(gb_t *gb, size_t count);
+uint64_t cpu_run_cycles(gb_t *gb, uint64_t cycles);
+uint64_t cpu_cycles(gb_t *gb);
+void cpu_print_state(gb_t *gb);
+uint64_t cpu_state_hash(gb_t *gb);
+bool cpu_set_dynarec(gb_t *gb, bool enable);
+void cpu_set_idle_skip(gb_t *gb, bool enable);
+void cpu_set_trace_print(gb_t *gb, bool enable);
+bool cpu_trace_start(gb_t *gb, const char *path, bool drop_on_overflow);
+uint64_t cpu_trace_stop(gb_t *gb);
 
 #endif /* __CPU_H__ */
@@ -0,0 +1,115 @@
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "disasm.h"
+#include "opcode.h"
+
+/*
+ * Text form of an instruction, built from the opcodes[] descriptors and
+ * the operand bytes that followed the opcode (`imm`, little-endian). Used
+ * by the execution trace and produces the same text the handlers used to
+ * print themselves.
+ */
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+static bool conditional_branch(instruction_e inst)
+{
+    switch(inst)
+    {
+	case INST_JR_Z: case INST_JR_NZ: case INST_JR_C: case INST_JR_NC:
+	case INST_JP_Z: case INST_JP_NZ: case INST_JP_C: case INST_JP_NC:
+	case INST_CALL_Z: case INST_CALL_NZ: case INST_CALL_C: case INST_CALL_NC:
+	    return true;
+	default:
+	    return false;
+    }
+}
+
+
+static int format_operand(char *buffer, size_t size, operand_t *operand, uint16_t imm)
+{
+    const char *reg = register_to_string(operand->reg);
+
+    switch(operand->type)
+    {
+	case OPERAND_TYPE_REGISTER_8BIT:
+	case OPERAND_TYPE_REGISTER_16BIT:
+	{
+	    return snprintf(buffer, size, operand->immediate ? "%s" : "[%s]", reg);
+	}
+	case OPERAND_TYPE_N8:
+	{
+	    return snprintf(buffer, size, "0x%02X", (uint8_t)imm);
+	}
+	case OPERAND_TYPE_E8:
+	{
+	    return snprintf(buffer, size, "%d", (int8_t)imm);
+	}
+	case OPERAND_TYPE_A8:
+	{
+	    if (operand->immediate)
+		return snprintf(buffer, size, "0x%02X", (uint8_t)imm);
+	    return snprintf(buffer, size, "[0x%04X]", 0xFF00 + (uint8_t)imm);
+	}
+	case OPERAND_TYPE_N16:
+	case OPERAND_TYPE_A16:
+	{
+	    return snprintf(buffer, size, operand->immediate ? "0x%04X" : "[0x%04X]", imm);
+	}
+	case OPERAND_TYPE_U3:
+	{
+	    return snprintf(buffer, size, "%d", operand->value);
+	}
+	default:
+	{
+	    buffer[0] = '\0';
+	    return 0;
+	}
+    }
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/* snprintf() semantics: returns the length of the full text. For the 0xCB
+ * prefix `imm` is the second opcode byte and the CB instruction is shown. */
+int disasm_format(char *buffer, size_t size, uint8_t value, uint16_t imm)
+{
+    opcode_t *opcode = value == 0xCB ? opcode_cb_get((uint8_t)imm) : opcode_get(value);
+    const char *mnemonic = instruction_to_string(opcode->inst);
+    char left[16], right[16];
+
+    switch(opcode->inst)
+    {
+	case INST_STOP:
+	case INST_HALT:
+	{
+	    /* no operand shown */
+	    return snprintf(buffer, size, "%s ", mnemonic);
+	}
+	case INST_RST:
+	{
+	    return snprintf(buffer, size, "%s 0x%02X", mnemonic, value & 0x38);
+	}
+	case INST_LD:
+	{
+	    if (opcode->op_right.type == OPERAND_TYPE_E8)
+		return snprintf(buffer, size, "%s HL, SP%+d", mnemonic, (int8_t)imm);
+	} break;
+	default:
+	    break;
+    }
+
+    if (opcode->op_left.type == OPERAND_TYPE_UNKNOWN)
+	return snprintf(buffer, size, "%s ", mnemonic);
+
+    format_operand(left, sizeof(left), &opcode->op_left, imm);
+    if (conditional_branch(opcode->inst))
+	return snprintf(buffer, size, "%s, %s", mnemonic, left);
+    if (opcode->op_right.type == OPERAND_TYPE_UNKNOWN)
+	return snprintf(buffer, size, "%s %s", mnemonic, left);
+
+    format_operand(right, sizeof(right), &opcode->op_right, imm);
+    return snprintf(buffer, size, "%s %s, %s", mnemonic, left, right);
+}
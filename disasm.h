@@ -0,0 +1,9 @@
+#ifndef __DISASM_H__
+#define __DISASM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+int disasm_format(char *buffer, size_t size, uint8_t opcode, uint16_t imm);
+
+#endif /* __DISASM_H__ */
@@ -0,0 +1,691 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "dynarec.h"
+#include "opcode.h"
+
+/*
+ * x86-64 dynamic recompiler.
+ *
+ * Translates the leading run of a guest basic block that only touches
+ * registers into native code: loads, 8-bit arithmetic and logic, INC and
+ * DEC, and the jump that ends the block. Guest A/B/C/D/E/H/L live in
+ * r8b-r14b and SP in r15w for the duration of the block; they are loaded
+ * from and stored back to the registers_t passed in rdi. Translation stops
+ * at the first instruction that accesses memory or I/O, calls or returns,
+ * or is not supported here, and the interpreter carries on from that point.
+ *
+ * The host's flags stand in for the guest's: x86 8-bit ADD/ADC/SUB/SBB/CMP,
+ * AND/OR/XOR and INC/DEC set ZF, CF and AF as the guest sets Z, C and H,
+ * and moves leave them alone. F is loaded into them only when an
+ * instruction reads a flag before the block has set one, and worked out
+ * from them only at the exits, with N and H of the last instruction to set
+ * them known at translation time. The caller hands over F up to date.
+ *
+ * The code buffer is never writable and executable at once: it is mapped
+ * read/write, and the pages of each block are made read/execute once it
+ * is written, and writable again only to write the next block there.
+ */
+
+#define DYNAREC_BUFFER_SIZE (1 << 20)
+#define DYNAREC_MAX_BLOCK   640 /* worst case bytes of host code per block */
+#define DYNAREC_MAX_EXIT    128 /* bytes of an exit, see emit_exit() */
+#define DYNAREC_MAX_OP      32  /* bytes of one instruction, flags load included */
+
+struct dynarec_s {
+    uint8_t *buffer;
+    size_t buffer_used;
+    size_t page_size;
+};
+
+#if defined(__x86_64__)
+
+/* host register numbers */
+enum {
+    HOST_R8 = 8, HOST_R9, HOST_R10, HOST_R11,
+    HOST_R12, HOST_R13, HOST_R14, HOST_R15,
+};
+
+typedef struct {
+    register_e guest;
+    uint8_t host;
+    uint8_t offset;
+} reg_map_t;
+
+static const reg_map_t reg_map[] =
+{
+    { REGISTER_A, HOST_R8,  offsetof(registers_t, A) },
+    { REGISTER_B, HOST_R9,  offsetof(registers_t, B) },
+    { REGISTER_C, HOST_R10, offsetof(registers_t, C) },
+    { REGISTER_D, HOST_R11, offsetof(registers_t, D) },
+    { REGISTER_E, HOST_R12, offsetof(registers_t, E) },
+    { REGISTER_H, HOST_R13, offsetof(registers_t, H) },
+    { REGISTER_L, HOST_R14, offsetof(registers_t, L) },
+};
+#define REG_MAP_COUNT (sizeof(reg_map) / sizeof(reg_map[0]))
+
+/* guest flags, as in cpu.c */
+#define FLAG_Z 0x80
+#define FLAG_N 0x40
+#define FLAG_H 0x20
+#define FLAG_C 0x10
+
+/* What the host's flags hold of the guest's at the current point of the
+ * translation */
+typedef struct {
+    bool live;       /* ZF and CF are the guest's Z and C */
+    bool written;    /* set in the block, so F is stored at its exits */
+    bool half_carry; /* H is AF, else it is in `bits` */
+    uint8_t bits;    /* N, and H unless half_carry */
+} guest_flags_t;
+
+/* 8-bit ALU instructions: the x86 "op r/m8, r8" opcode and the /digit of
+ * "op r/m8, imm8", the N and H they leave, and whether they read C */
+typedef struct {
+    uint8_t reg_opcode;
+    uint8_t imm_digit;
+    uint8_t bits;
+    bool half_carry;
+    bool reads_carry;
+} alu_map_t;
+
+static const alu_map_t alu_map[] =
+{
+    [INST_ADD] = { 0x00, 0, 0,      true,  false },
+    [INST_ADC] = { 0x10, 2, 0,      true,  true  },
+    [INST_SUB] = { 0x28, 5, FLAG_N, true,  false },
+    [INST_SBC] = { 0x18, 3, FLAG_N, true,  true  },
+    [INST_AND] = { 0x20, 4, FLAG_H, false, false },
+    [INST_XOR] = { 0x30, 6, 0,      false, false },
+    [INST_OR]  = { 0x08, 1, 0,      false, false },
+    [INST_CP]  = { 0x38, 7, FLAG_N, true,  false },
+};
+
+/* ======= PRIVATE FUNCTIONS ======= */
+static inline void emit8(uint8_t **p, uint8_t byte)
+{
+    *(*p)++ = byte;
+}
+
+
+static inline void emit16(uint8_t **p, uint16_t value)
+{
+    emit8(p, (uint8_t)value);
+    emit8(p, (uint8_t)(value >> 8));
+}
+
+
+static inline void emit32(uint8_t **p, uint32_t value)
+{
+    emit16(p, (uint16_t)value);
+    emit16(p, (uint16_t)(value >> 16));
+}
+
+
+static int host_reg8(register_e reg)
+{
+    for (size_t i = 0; i < REG_MAP_COUNT; i++)
+    {
+	if (reg_map[i].guest == reg)
+	    return reg_map[i].host;
+    }
+    return -1;
+}
+
+
+/* mov r8b..r15b, imm8 */
+static void emit_mov_r8_imm(uint8_t **p, int host, uint8_t value)
+{
+    emit8(p, 0x41);
+    emit8(p, 0xB0 + (host & 7));
+    emit8(p, value);
+}
+
+
+/* mov dst8, src8 (both r8b..r15b) */
+static void emit_mov_r8_r8(uint8_t **p, int dst, int src)
+{
+    emit8(p, 0x45);
+    emit8(p, 0x88);
+    emit8(p, 0xC0 | ((src & 7) << 3) | (dst & 7));
+}
+
+
+/* Host register holding the guest byte at `offset` in registers_t */
+static int host_reg_at(size_t offset)
+{
+    for (size_t i = 0; i < REG_MAP_COUNT; i++)
+    {
+	if (reg_map[i].offset == offset)
+	    return reg_map[i].host;
+    }
+    return -1;
+}
+
+
+/* Load a little-endian immediate into the register pair stored at
+ * `offset`, following the in-memory layout of registers_t */
+static void emit_mov_pair_imm(uint8_t **p, size_t offset, const uint8_t *operand)
+{
+    emit_mov_r8_imm(p, host_reg_at(offset), operand[0]);
+    emit_mov_r8_imm(p, host_reg_at(offset + 1), operand[1]);
+}
+
+
+static void emit_prologue(uint8_t **p)
+{
+    /* push r12..r15 */
+    for (int host = HOST_R12; host <= HOST_R15; host++)
+    {
+	emit8(p, 0x41);
+	emit8(p, 0x50 + (host & 7));
+    }
+
+    /* movzx host32, byte [rdi + offset] */
+    for (size_t i = 0; i < REG_MAP_COUNT; i++)
+    {
+	emit8(p, 0x44);
+	emit8(p, 0x0F);
+	emit8(p, 0xB6);
+	emit8(p, 0x47 | ((reg_map[i].host & 7) << 3));
+	emit8(p, reg_map[i].offset);
+    }
+
+    /* movzx r15d, word [rdi + SP] */
+    emit8(p, 0x44);
+    emit8(p, 0x0F);
+    emit8(p, 0xB7);
+    emit8(p, 0x47 | ((HOST_R15 & 7) << 3));
+    emit8(p, offsetof(registers_t, SP));
+}
+
+
+/* Put guest Z and C from F into ZF and CF, ahead of the first instruction
+ * to read a flag the block hasn't set */
+static void emit_flags_load(uint8_t **p, guest_flags_t *flags)
+{
+    static const uint8_t load[] =
+    {
+	0x89, 0xC1,             /* mov ecx, eax */
+	0xC1, 0xE9, 0x01,       /* shr ecx, 1 */
+	0x83, 0xE1, 0x40,       /* and ecx, 0x40 ; Z to ZF */
+	0xC1, 0xE8, 0x04,       /* shr eax, 4 */
+	0x83, 0xE0, 0x01,       /* and eax, 1 ; C to CF */
+	0x09, 0xC8,             /* or eax, ecx */
+	0x88, 0xC4,             /* mov ah, al */
+	0x9E,                   /* sahf */
+    };
+
+    if (flags->live)
+	return;
+
+    /* movzx eax, byte [rdi + F] */
+    emit8(p, 0x0F);
+    emit8(p, 0xB6);
+    emit8(p, 0x47);
+    emit8(p, offsetof(registers_t, F));
+    for (size_t i = 0; i < sizeof(load); i++)
+    {
+	emit8(p, load[i]);
+    }
+    flags->live = true;
+}
+
+
+/* Work F out from ZF, CF and AF, if the block has set the flags */
+static void emit_flags_store(uint8_t **p, const guest_flags_t *flags)
+{
+    static const uint8_t store[] =
+    {
+	0x9F,                   /* lahf */
+	0x0F, 0xB6, 0xCC,       /* movzx ecx, ah */
+	0x89, 0xC8,             /* mov eax, ecx */
+	0x83, 0xE0, 0x40,       /* and eax, 0x40 */
+	0x01, 0xC0,             /* add eax, eax ; ZF to Z */
+	0x89, 0xCA,             /* mov edx, ecx */
+	0x83, 0xE2, 0x01,       /* and edx, 1 */
+	0xC1, 0xE2, 0x04,       /* shl edx, 4 ; CF to C */
+	0x09, 0xD0,             /* or eax, edx */
+    };
+    static const uint8_t half_carry[] =
+    {
+	0x83, 0xE1, 0x10,       /* and ecx, 0x10 */
+	0x01, 0xC9,             /* add ecx, ecx ; AF to H */
+	0x09, 0xC8,             /* or eax, ecx */
+    };
+
+    if (!flags->written)
+	return;
+
+    for (size_t i = 0; i < sizeof(store); i++)
+    {
+	emit8(p, store[i]);
+    }
+    if (flags->half_carry)
+    {
+	for (size_t i = 0; i < sizeof(half_carry); i++)
+	{
+	    emit8(p, half_carry[i]);
+	}
+    }
+    if (flags->bits)
+    {
+	/* or eax, bits */
+	emit8(p, 0x83);
+	emit8(p, 0xC8);
+	emit8(p, flags->bits);
+    }
+
+    /* mov byte [rdi + F], al */
+    emit8(p, 0x88);
+    emit8(p, 0x47);
+    emit8(p, offsetof(registers_t, F));
+}
+
+
+/* Leave the block for the interpreter to go on at `pc` */
+static void emit_exit(uint8_t **p, const guest_flags_t *flags, uint16_t pc, uint8_t ir,
+		      uint32_t cycles)
+{
+    emit_flags_store(p, flags);
+
+    /* mov byte [rdi + offset], host8 */
+    for (size_t i = 0; i < REG_MAP_COUNT; i++)
+    {
+	emit8(p, 0x44);
+	emit8(p, 0x88);
+	emit8(p, 0x47 | ((reg_map[i].host & 7) << 3));
+	emit8(p, reg_map[i].offset);
+    }
+
+    /* mov word [rdi + SP], r15w */
+    emit8(p, 0x66);
+    emit8(p, 0x44);
+    emit8(p, 0x89);
+    emit8(p, 0x47 | ((HOST_R15 & 7) << 3));
+    emit8(p, offsetof(registers_t, SP));
+
+    /* mov word [rdi + PC], pc ; mov word [rdi + IR], ir */
+    emit8(p, 0x66);
+    emit8(p, 0xC7);
+    emit8(p, 0x47);
+    emit8(p, offsetof(registers_t, PC));
+    emit16(p, pc);
+    emit8(p, 0x66);
+    emit8(p, 0xC7);
+    emit8(p, 0x47);
+    emit8(p, offsetof(registers_t, IR));
+    emit16(p, ir);
+
+    /* mov eax, cycles */
+    emit8(p, 0xB8);
+    emit32(p, cycles);
+
+    /* pop r15..r12 ; ret */
+    for (int host = HOST_R15; host >= HOST_R12; host--)
+    {
+	emit8(p, 0x41);
+	emit8(p, 0x58 + (host & 7));
+    }
+    emit8(p, 0xC3);
+}
+
+
+/* A, B, C, D, E, H or L as an operand, -1 if it is anything else */
+static int operand_reg8(const operand_t *operand)
+{
+    if (operand->type != OPERAND_TYPE_REGISTER_8BIT || !operand->immediate)
+	return -1;
+    return host_reg8(operand->reg);
+}
+
+
+/* ADD/ADC/SUB/SBC/AND/XOR/OR/CP A, r or A, n8 */
+static bool emit_alu(uint8_t **p, opcode_t *opcode, const uint8_t *operand,
+		     guest_flags_t *flags)
+{
+    const alu_map_t *alu = &alu_map[opcode->inst];
+    int src = operand_reg8(&opcode->op_right);
+
+    if (operand_reg8(&opcode->op_left) != HOST_R8)
+	return false;
+    if (src < 0 && opcode->op_right.type != OPERAND_TYPE_N8)
+	return false;
+
+    if (alu->reads_carry)
+	emit_flags_load(p, flags);
+    if (src >= 0)
+    {
+	/* op r8b, src8 */
+	emit8(p, 0x45);
+	emit8(p, alu->reg_opcode);
+	emit8(p, 0xC0 | ((src & 7) << 3) | (HOST_R8 & 7));
+    }
+    else
+    {
+	/* op r8b, imm8 */
+	emit8(p, 0x41);
+	emit8(p, 0x80);
+	emit8(p, 0xC0 | (alu->imm_digit << 3) | (HOST_R8 & 7));
+	emit8(p, operand[0]);
+    }
+    flags->live = true;
+    flags->written = true;
+    flags->half_carry = alu->half_carry;
+    flags->bits = alu->bits;
+    return true;
+}
+
+
+/* INC r or DEC r, which keep C as the x86 ones keep CF */
+static bool emit_inc_dec(uint8_t **p, opcode_t *opcode, guest_flags_t *flags)
+{
+    int reg = operand_reg8(&opcode->op_left);
+
+    if (reg < 0)
+	return false;
+
+    emit_flags_load(p, flags);
+    /* inc/dec r8b..r15b */
+    emit8(p, 0x41);
+    emit8(p, 0xFE);
+    emit8(p, (opcode->inst == INST_INC ? 0xC0 : 0xC8) | (reg & 7));
+    flags->written = true;
+    flags->half_carry = true;
+    flags->bits = opcode->inst == INST_DEC ? FLAG_N : 0;
+    return true;
+}
+
+
+/* Emit one guest instruction, returns false if it can't be translated */
+static bool emit_instruction(uint8_t **p, opcode_t *opcode, const uint8_t *operand,
+			     guest_flags_t *flags)
+{
+    operand_t *left = &opcode->op_left;
+    operand_t *right = &opcode->op_right;
+
+    switch(opcode->inst)
+    {
+	case INST_NOP:
+	{
+	    /* undefined opcodes decode as an empty NOP entry */
+	    return opcode->bytes == 1;
+	}
+	case INST_ADD:
+	case INST_ADC:
+	case INST_SUB:
+	case INST_SBC:
+	case INST_AND:
+	case INST_XOR:
+	case INST_OR:
+	case INST_CP:
+	{
+	    return emit_alu(p, opcode, operand, flags);
+	}
+	case INST_INC:
+	case INST_DEC:
+	{
+	    return emit_inc_dec(p, opcode, flags);
+	}
+	case INST_LD:
+	{
+	    if (!left->immediate || !right->immediate)
+		return false;
+
+	    if (left->type == OPERAND_TYPE_REGISTER_8BIT &&
+		right->type == OPERAND_TYPE_REGISTER_8BIT)
+	    {
+		int dst = host_reg8(left->reg);
+		int src = host_reg8(right->reg);
+		if (dst < 0 || src < 0)
+		    return false;
+		emit_mov_r8_r8(p, dst, src);
+		return true;
+	    }
+
+	    if (left->type == OPERAND_TYPE_REGISTER_8BIT &&
+		right->type == OPERAND_TYPE_N8)
+	    {
+		int dst = host_reg8(left->reg);
+		if (dst < 0)
+		    return false;
+		emit_mov_r8_imm(p, dst, operand[0]);
+		return true;
+	    }
+
+	    if (left->type == OPERAND_TYPE_REGISTER_16BIT &&
+		right->type == OPERAND_TYPE_N16)
+	    {
+		switch(left->reg)
+		{
+		    case REGISTER_BC:
+			emit_mov_pair_imm(p, offsetof(registers_t, BC), operand);
+			return true;
+		    case REGISTER_DE:
+			emit_mov_pair_imm(p, offsetof(registers_t, DE), operand);
+			return true;
+		    case REGISTER_HL:
+			emit_mov_pair_imm(p, offsetof(registers_t, HL), operand);
+			return true;
+		    case REGISTER_SP:
+			/* mov r15d, imm32 */
+			emit8(p, 0x41);
+			emit8(p, 0xB8 + (HOST_R15 & 7));
+			emit32(p, operand[0] | (operand[1] << 8));
+			return true;
+		    default:
+			return false;
+		}
+	    }
+	    return false;
+	}
+	default:
+	{
+	    return false;
+	}
+    }
+}
+
+
+/* The x86 jcc rel32 second opcode byte for a conditional JR/JP, 0 for an
+ * unconditional one, -1 for anything else */
+static int jump_condition(instruction_e inst)
+{
+    switch(inst)
+    {
+	case INST_JR: case INST_JP: return 0;
+	case INST_JR_NZ: case INST_JP_NZ: return 0x85; /* jne */
+	case INST_JR_Z: case INST_JP_Z: return 0x84;   /* je */
+	case INST_JR_NC: case INST_JP_NC: return 0x83; /* jae, i.e. CF clear */
+	case INST_JR_C: case INST_JP_C: return 0x82;   /* jb, i.e. CF set */
+	default: return -1;
+    }
+}
+
+
+/*
+ * JR or JP to an immediate target, which ends the block: exits to the
+ * target, and for a conditional one also to `next` when not taken.
+ * `cycles` are those of the instructions before. Returns false, having
+ * emitted nothing, for anything else.
+ */
+static bool emit_jump(uint8_t **p, opcode_t *opcode, const uint8_t *operand,
+		      guest_flags_t *flags, uint16_t next, uint8_t ir, uint32_t cycles)
+{
+    int condition = jump_condition(opcode->inst);
+    uint16_t target;
+
+    switch(opcode->op_left.type)
+    {
+	case OPERAND_TYPE_E8: target = next + (int8_t)operand[0]; break;
+	case OPERAND_TYPE_A16: target = operand[0] | operand[1] << 8; break;
+	default: return false;
+    }
+    if (condition < 0)
+	return false;
+
+    cycles += opcode->cycles;
+    if (condition)
+    {
+	uint8_t *rel;
+
+	emit_flags_load(p, flags);
+	/* jcc rel32 to the taken exit, past the other */
+	emit8(p, 0x0F);
+	emit8(p, condition);
+	rel = *p;
+	emit32(p, 0);
+	emit_exit(p, flags, next, ir, cycles);
+	emit32(&rel, *p - (rel + 4));
+	/* a taken conditional branch costs 4 more */
+	cycles += 4;
+    }
+    emit_exit(p, flags, target, ir, cycles);
+    return true;
+}
+
+
+/* Make the pages `start` writes a block to writable, or executable again */
+static bool code_writable(dynarec_t *dynarec, uint8_t *start, bool writable)
+{
+    uintptr_t first = (uintptr_t)start & ~(dynarec->page_size - 1);
+    uintptr_t end = (uintptr_t)(start + DYNAREC_MAX_BLOCK + dynarec->page_size - 1) &
+		    ~(dynarec->page_size - 1);
+
+    return mprotect((void *)first, end - first,
+		    PROT_READ | (writable ? PROT_WRITE : PROT_EXEC)) == 0;
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/* Returns NULL if executable memory can't be had */
+dynarec_t *dynarec_create()
+{
+    dynarec_t *dynarec = calloc(1, sizeof(dynarec_t));
+
+    if (!dynarec)
+	return NULL;
+
+    dynarec->page_size = sysconf(_SC_PAGESIZE);
+    dynarec->buffer = mmap(NULL, DYNAREC_BUFFER_SIZE, PROT_READ | PROT_WRITE,
+			   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (dynarec->buffer == MAP_FAILED)
+    {
+	free(dynarec);
+	return NULL;
+    }
+    return dynarec;
+}
+
+
+void dynarec_destroy(dynarec_t *dynarec)
+{
+    if (!dynarec)
+	return;
+    munmap(dynarec->buffer, DYNAREC_BUFFER_SIZE);
+    free(dynarec);
+}
+
+
+/*
+ * Translate up to `max_instructions` of `code`, the bytes from `pc` on,
+ * which must hold that many instructions. On success returns
+ * the native function and the number of guest instructions it covers. Returns NULL
+ * with *instructions == 0 when the first instruction can't be translated,
+ * or NULL with *instructions != 0 when the code buffer is full and the
+ * caller should drop its translations, dynarec_flush() and retry.
+ */
+dynarec_block_fn dynarec_compile(dynarec_t *dynarec, const uint8_t *code, uint16_t pc,
+				 size_t max_instructions, size_t *instructions)
+{
+    guest_flags_t flags = { false };
+    uint8_t *start, *p;
+    uint32_t address = pc;
+    uint32_t cycles = 0;
+    uint8_t ir = 0;
+    size_t count = 0;
+    bool jumped = false;
+
+    *instructions = 0;
+    if (dynarec->buffer_used + DYNAREC_MAX_BLOCK > DYNAREC_BUFFER_SIZE)
+    {
+	*instructions = 1;
+	return NULL;
+    }
+
+    start = p = dynarec->buffer + dynarec->buffer_used;
+    if (!code_writable(dynarec, start, true))
+	return NULL;
+    emit_prologue(&p);
+
+    /* leave room for an instruction and two exits within DYNAREC_MAX_BLOCK */
+    while (count < max_instructions &&
+	   p - start <= DYNAREC_MAX_BLOCK - DYNAREC_MAX_OP - 2 * DYNAREC_MAX_EXIT)
+    {
+	uint8_t value = code[address - pc];
+	opcode_t *opcode = opcode_get(value);
+	const uint8_t *operand = &code[address - pc + 1];
+
+	if (address + opcode->bytes > 0xFFFF + 0x0001)
+	    break;
+	if (emit_jump(&p, opcode, operand, &flags, address + opcode->bytes, value, cycles))
+	{
+	    jumped = true;
+	    count++;
+	    break;
+	}
+	if (!emit_instruction(&p, opcode, operand, &flags))
+	    break;
+	ir = value;
+	cycles += opcode->cycles;
+	address += opcode->bytes;
+	count++;
+    }
+
+    if (count && !jumped)
+	emit_exit(&p, &flags, (uint16_t)address, ir, cycles);
+    if (!code_writable(dynarec, start, false) || count == 0)
+	return NULL;
+
+    dynarec->buffer_used += p - start;
+    *instructions = count;
+
+    return (dynarec_block_fn)start;
+}
+
+
+void dynarec_flush(dynarec_t *dynarec)
+{
+    dynarec->buffer_used = 0;
+}
+
+#else /* !__x86_64__ */
+
+dynarec_t *dynarec_create()
+{
+    return NULL;
+}
+
+
+void dynarec_destroy(dynarec_t *dynarec)
+{
+}
+
+
+dynarec_block_fn dynarec_compile(dynarec_t *dynarec, const uint8_t *code, uint16_t pc,
+				 size_t max_instructions, size_t *instructions)
+{
+    *instructions = 0;
+    return NULL;
+}
+
+
+void dynarec_flush(dynarec_t *dynarec)
+{
+}
+
+#endif /* __x86_64__ */
@@ -0,0 +1,26 @@
+#ifndef __DYNAREC_H__
+#define __DYNAREC_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "register.h"
+
+/* A translated block. Runs against the guest register file, F included,
+ * which has to be up to date rather than held in lazy flags. Leaves PC
+ * past the last translated instruction, or at the target of the jump it
+ * ended with, and IR holding that instruction, and returns the number of
+ * cycles it accounted for. */
+typedef uint32_t (*dynarec_block_fn)(registers_t *reg);
+
+/* Code buffer of one emulator instance */
+typedef struct dynarec_s dynarec_t;
+
+dynarec_t *dynarec_create();
+void dynarec_destroy(dynarec_t *dynarec);
+dynarec_block_fn dynarec_compile(dynarec_t *dynarec, const uint8_t *code, uint16_t pc,
+				 size_t max_instructions, size_t *instructions);
+void dynarec_flush(dynarec_t *dynarec);
+
+#endif /* __DYNAREC_H__ */
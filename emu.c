@@ -0,0 +1,72 @@
+#include "cart.h"
+#include "emu.h"
+#include "gb.h"
+#include "io.h"
+#include "mbc.h"
+
+/*
+ * Whole-machine entry points for frontends, built on cpu_run_cycles() so
+ * the per-instruction loop stays inside the core.
+ */
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/*
+ * Run until the LCD enters VBlank, as predicted when the call is made,
+ * or for a frame's worth of cycles while the LCD is off. Returns the
+ * cycles run.
+ */
+uint64_t emu_run_frame(gb_t *gb)
+{
+    return cpu_run_cycles(gb, io_next_vblank(&gb->io, gb->cycles) - gb->cycles);
+}
+
+
+/*
+ * Insert the cartridge in the ROM image at `path`, see cart.h, and start
+ * from its entry point at 0x0100, as the boot ROM would leave it. Meant
+ * for a fresh instance, before anything has run. Returns false if the
+ * file can't be mapped.
+ */
+bool emu_load_rom(gb_t *gb, const char *path)
+{
+    cart_t *cart = cart_open(path);
+
+    if (!cart)
+	return false;
+    if (!cart_insert(gb, cart))
+    {
+	cart_release(cart);
+	return false;
+    }
+    cart_release(cart);
+
+    gb->reg.PC = 0x0100;
+    gb->reg.SP = 0xFFFE;
+    return true;
+}
+
+
+/* Run the cartridge's clock, if it has one, in real time rather than
+ * emulated time, see mbc.h */
+void emu_set_rtc_realtime(gb_t *gb, bool realtime)
+{
+    mbc_set_rtc_realtime(gb, realtime);
+}
+
+
+/* Keep the cartridge's RAM in the save file at `path`, see save.h.
+ * Returns false if there is no cartridge RAM or the file can't be mapped. */
+bool emu_attach_save(gb_t *gb, const char *path)
+{
+    return cart_attach_save(gb, path, SAVE_INTERVAL_DEFAULT_MS);
+}
+
+
+/* The screen as last drawn, PPU_HEIGHT lines of PPU_WIDTH shades from 0,
+ * white, to 3, black */
+const uint8_t *emu_framebuffer(const gb_t *gb)
+{
+    return &gb->ppu.framebuffer[0][0];
+}
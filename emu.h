@@ -0,0 +1,20 @@
+#ifndef __EMU_H__
+#define __EMU_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cpu.h"
+#include "ppu.h"
+
+/* Cycles of a video frame, 154 lines of 456, for hosts that run by the
+ * cycle rather than with emu_run_frame() */
+#define EMU_FRAME_CYCLES 70224
+
+uint64_t emu_run_frame(gb_t *gb);
+bool emu_load_rom(gb_t *gb, const char *path);
+bool emu_attach_save(gb_t *gb, const char *path);
+void emu_set_rtc_realtime(gb_t *gb, bool realtime);
+const uint8_t *emu_framebuffer(const gb_t *gb);
+
+#endif /* __EMU_H__ */
@@ -0,0 +1,413 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cpu.h"
+#include "emu.h"
+#include "forkserver.h"
+
+/*
+ * The server is one process that never runs the instance past the point
+ * it was handed over at. It polls the listening socket and its clients,
+ * and forks on every complete job line, so the instance's pages only get
+ * copied as a child writes them. A child answers on the client's own
+ * descriptor and exits. At most options->jobs run at once: past that the
+ * lines read are left waiting and the clients aren't read from until a
+ * child exits, which wakes the poll through a pipe written by the SIGCHLD
+ * handler. The server itself never blocks on a child, so a client that
+ * doesn't read its answers only holds up its own jobs' slots.
+ */
+#define FORKSERVER_LINE_MAX 256
+
+typedef struct {
+    int in;          /* jobs come in on in, answers go out on out */
+    int out;
+    bool done;       /* nothing more to read */
+    size_t length;   /* of what was read and not started yet */
+    char line[FORKSERVER_LINE_MAX];
+} client_t;
+
+typedef struct {
+    gb_t *gb;
+    int listener;    /* -1 when taking jobs on stdin */
+    int jobs;
+    int running;
+    client_t *clients;
+    size_t count;
+    size_t capacity;
+} server_t;
+
+/* Written to on SIGCHLD, so there is one server per process */
+static int child_exited_pipe[2];
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/* One line in a single write, so answers from concurrent children don't
+ * interleave */
+static void answer(int fd, const char *format, ...)
+{
+    char line[FORKSERVER_LINE_MAX + 64];
+    va_list args;
+    int length;
+
+    va_start(args, format);
+    length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length < 0)
+	return;
+    if ((size_t)length >= sizeof(line))
+	length = sizeof(line) - 1;
+    while (length > 0)
+    {
+	ssize_t written = write(fd, line, length);
+
+	if (written < 0 && errno == EINTR)
+	    continue;
+	if (written <= 0)
+	    return;
+	memmove(line, line + written, length - written);
+	length -= written;
+    }
+}
+
+
+/* Reap the children that are done, waiting for them all if `block` */
+static void reap(server_t *server, bool block)
+{
+    while (server->running > 0)
+    {
+	pid_t pid = waitpid(-1, NULL, block ? 0 : WNOHANG);
+
+	if (pid < 0 && errno == EINTR)
+	    continue;
+	if (pid < 0 && errno == ECHILD)
+	    server->running = 0;
+	if (pid <= 0)
+	    return;
+	server->running--;
+    }
+}
+
+
+static void child_exited(int signal)
+{
+    int saved = errno;
+    char byte = 0;
+    ssize_t written;
+
+    (void)signal;
+    /* if the pipe is full, the server is already due to wake */
+    written = write(child_exited_pipe[1], &byte, 1);
+    (void)written;
+    errno = saved;
+}
+
+
+/* In the child: run the job and answer. Never returns. */
+static void job_run(server_t *server, const client_t *client, const char *id, long frames)
+{
+    gb_t *gb = server->gb;
+    uint64_t cycles = cpu_cycles(gb);
+    double start = now_seconds();
+
+    if (server->listener >= 0)
+	close(server->listener);
+    for (long frame = 0; frame < frames; frame++)
+    {
+	emu_run_frame(gb);
+    }
+    answer(client->out, "%s ok %llu %016llx %.6f\n", id,
+	   (unsigned long long)(cpu_cycles(gb) - cycles),
+	   (unsigned long long)cpu_state_hash(gb), now_seconds() - start);
+    _exit(0);
+}
+
+
+static void job_start(server_t *server, const client_t *client, char *line)
+{
+    char *id, *end;
+    long frames;
+    pid_t pid;
+
+    id = strtok(line, " \t\r\n");
+    if (!id)
+	return;
+    end = strtok(NULL, " \t\r\n");
+    frames = end ? strtol(end, &end, 0) : -1;
+    if (!end || *end != '\0' || frames < 0 || strtok(NULL, " \t\r\n"))
+    {
+	answer(client->out, "%s error expected `ID FRAMES`\n", id);
+	return;
+    }
+
+    pid = fork();
+    if (pid == 0)
+	job_run(server, client, id, frames);
+    if (pid < 0)
+    {
+	answer(client->out, "%s error fork failed\n", id);
+	return;
+    }
+    server->running++;
+}
+
+
+/* Start the jobs of the complete lines read, as long as there is room
+ * for them. Returns true if some are left waiting. */
+static bool client_jobs(server_t *server, client_t *client)
+{
+    char *line = client->line;
+    char *newline = NULL;
+
+    while (server->running < server->jobs &&
+	   (newline = memchr(line, '\n', client->length - (line - client->line))))
+    {
+	*newline = '\0';
+	job_start(server, client, line);
+	line = newline + 1;
+    }
+    client->length -= line - client->line;
+    memmove(client->line, line, client->length);
+
+    if (client->length == sizeof(client->line) && !memchr(client->line, '\n', client->length))
+    {
+	answer(client->out, "- error line too long\n");
+	client->length = 0;
+	client->done = true;
+    }
+    return memchr(client->line, '\n', client->length) != NULL;
+}
+
+
+/* Read what the client sent, up to the room left for it */
+static void client_read(client_t *client)
+{
+    ssize_t count = read(client->in, client->line + client->length,
+			 sizeof(client->line) - client->length);
+
+    if (count > 0)
+	client->length += count;
+    else if (count == 0 || (errno != EINTR && errno != EAGAIN))
+	client->done = true;
+}
+
+
+static bool client_add(server_t *server, int in, int out)
+{
+    client_t *client;
+
+    if (server->count == server->capacity)
+    {
+	size_t grown = server->capacity ? server->capacity * 2 : 16;
+	client_t *clients = realloc(server->clients, grown * sizeof(client_t));
+
+	if (!clients)
+	    return false;
+	server->clients = clients;
+	server->capacity = grown;
+    }
+    client = &server->clients[server->count++];
+    client->in = in;
+    client->out = out;
+    client->done = false;
+    client->length = 0;
+    return true;
+}
+
+
+static void client_remove(server_t *server, size_t index)
+{
+    client_t *client = &server->clients[index];
+
+    if (server->listener >= 0)
+	close(client->in);
+    *client = server->clients[--server->count];
+}
+
+
+/* Wake the poll whenever a child exits */
+static bool catch_child_exits()
+{
+    struct sigaction action = { .sa_handler = child_exited,
+				.sa_flags = SA_RESTART | SA_NOCLDSTOP };
+
+    if (pipe(child_exited_pipe) != 0)
+	return false;
+    for (int i = 0; i < 2; i++)
+    {
+	fcntl(child_exited_pipe[i], F_SETFL, O_NONBLOCK);
+	fcntl(child_exited_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+    sigemptyset(&action.sa_mask);
+    return sigaction(SIGCHLD, &action, NULL) == 0;
+}
+
+
+/* A Unix stream socket listening at `path`, replacing whatever was
+ * there. Returns -1, after saying why on stderr, on failure. */
+static int listen_socket(const char *path)
+{
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    int fd;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+	fprintf(stderr, "%s: socket path too long\n", path);
+	return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+	perror("socket");
+	return -1;
+    }
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+	listen(fd, SOMAXCONN) != 0)
+    {
+	fprintf(stderr, "%s: %s\n", path, strerror(errno));
+	close(fd);
+	return -1;
+    }
+    return fd;
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/*
+ * Serve jobs from the state `gb` is in, see forkserver.h. Taking them on
+ * stdin, returns once it is closed and every job has answered. On a
+ * socket, serves until killed. Returns false, after saying why on stderr,
+ * if the server can't be set up.
+ */
+bool forkserver_run(gb_t *gb, const forkserver_options_t *options)
+{
+    server_t server = { .gb = gb, .listener = -1, .jobs = options->jobs };
+    struct pollfd *fds = NULL;
+    char drain[64];
+    bool ok = true;
+
+    if (server.jobs <= 0)
+	server.jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (server.jobs <= 0)
+	server.jobs = 1;
+    /* answering a client that has gone away must not kill the child */
+    signal(SIGPIPE, SIG_IGN);
+    /* nothing buffered may be written again by every child */
+    fflush(NULL);
+    if (!catch_child_exits())
+    {
+	perror("fork server");
+	return false;
+    }
+
+    if (options->socket_path)
+    {
+	server.listener = listen_socket(options->socket_path);
+	if (server.listener < 0)
+	    return false;
+    }
+    else if (!client_add(&server, STDIN_FILENO, STDOUT_FILENO))
+    {
+	fprintf(stderr, "out of memory\n");
+	return false;
+    }
+
+    while (server.listener >= 0 || server.count > 0)
+    {
+	size_t count = 0;
+	struct pollfd *grown;
+
+	reap(&server, false);
+	/* backwards, as removing a client moves the last one into its slot */
+	for (size_t i = server.count; i-- > 0;)
+	{
+	    if (!client_jobs(&server, &server.clients[i]) && server.clients[i].done)
+		client_remove(&server, i);
+	}
+	if (server.listener < 0 && server.count == 0)
+	    break;
+
+	grown = realloc(fds, (server.count + 2) * sizeof(struct pollfd));
+	if (!grown)
+	{
+	    fprintf(stderr, "out of memory\n");
+	    ok = false;
+	    break;
+	}
+	fds = grown;
+	fds[count++] = (struct pollfd){ .fd = child_exited_pipe[0], .events = POLLIN };
+	if (server.listener >= 0)
+	    fds[count++] = (struct pollfd){ .fd = server.listener, .events = POLLIN };
+	/* at the limit, clients wait for a child to exit before being read */
+	for (size_t i = 0; i < server.count && server.running < server.jobs; i++)
+	{
+	    short events = server.clients[i].done ? 0 : POLLIN;
+
+	    fds[count++] = (struct pollfd){ .fd = server.clients[i].in, .events = events };
+	}
+
+	if (poll(fds, count, -1) < 0)
+	{
+	    if (errno == EINTR)
+		continue;
+	    perror("poll");
+	    ok = false;
+	    break;
+	}
+
+	if (fds[0].revents)
+	{
+	    while (read(child_exited_pipe[0], drain, sizeof(drain)) > 0)
+		;
+	}
+	for (size_t i = 1 + (server.listener >= 0); i < count; i++)
+	{
+	    if (fds[i].revents)
+		client_read(&server.clients[i - 1 - (server.listener >= 0)]);
+	}
+	if (server.listener >= 0 && (fds[1].revents & POLLIN))
+	{
+	    int fd = accept(server.listener, NULL, NULL);
+
+	    if (fd >= 0 && !client_add(&server, fd, fd))
+		close(fd);
+	}
+    }
+
+    free(fds);
+    reap(&server, true);
+    while (server.count > 0)
+    {
+	client_remove(&server, server.count - 1);
+    }
+    free(server.clients);
+    if (server.listener >= 0)
+	close(server.listener);
+    signal(SIGCHLD, SIG_DFL);
+    close(child_exited_pipe[0]);
+    close(child_exited_pipe[1]);
+    return ok;
+}
@@ -0,0 +1,27 @@
+#ifndef __FORKSERVER_H__
+#define __FORKSERVER_H__
+
+#include <stdbool.h>
+
+#include "cpu.h"
+
+/*
+ * Fork server: takes an instance already booted and run to where every
+ * job starts, and forks a child for each job so the jobs start from that
+ * state without repeating the startup, sharing its memory copy-on-write.
+ *
+ * Jobs are lines of `ID FRAMES`. The child for a job runs FRAMES frames
+ * and answers with one line, `ID ok CYCLES HASH SECONDS` or `ID error
+ * MESSAGE`, where ID is echoed as given. Jobs run concurrently, so the
+ * answers come back in the order the jobs finish.
+ */
+typedef struct {
+    const char *socket_path; /* Unix socket to listen on, NULL for stdin
+				and stdout */
+    int jobs;                /* children running at once, 0 for one per
+				online CPU */
+} forkserver_options_t;
+
+bool forkserver_run(gb_t *gb, const forkserver_options_t *options);
+
+#endif /* __FORKSERVER_H__ */
@@ -0,0 +1,236 @@
+#ifndef __GB_H__
+#define __GB_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bus.h"
+#include "cart.h"
+#include "cpu.h"
+#include "dynarec.h"
+#include "io.h"
+#include "mbc.h"
+#include "ppu.h"
+#include "register.h"
+#include "save.h"
+#include "scheduler.h"
+#include "trace.h"
+
+/*
+ * Layout of the emulator context, for the modules that make up the core.
+ * Frontends only see the opaque gb_t from cpu.h.
+ */
+
+/* Lazy flags, see cpu.c */
+typedef struct {
+    uint8_t op;     /* flags_op_e in cpu.c, of the last ALU instruction */
+    uint8_t a;
+    uint8_t b;
+    uint8_t carry;
+    uint8_t result;
+} lazy_flags_t;
+
+typedef void (*opcode_handler_t)(gb_t *gb, uint16_t imm);
+
+#define GB_PAGE_SHIFT 8
+#define GB_PAGE_SIZE  (1 << GB_PAGE_SHIFT)
+#define GB_PAGES      ((0xFFFF + 0x0001) >> GB_PAGE_SHIFT)
+/* OAM DMA and the I/O registers io.c keeps in memory are written without
+ * going through the bus, so the pages from here up never get stamped */
+#define GB_IO_PAGE    (0xFE00 >> GB_PAGE_SHIFT)
+
+/* Cartridge RAM is seen through the pages at 0xA000-0xBFFF, which are their
+ * own homes (see mbc.c). States hold it after RAM[], as GB_PAGES on, so an
+ * instance's state is gb_state_pages() pages of at most GB_STATE_PAGES. */
+#define GB_CART_RAM_PAGE  (0xA000 >> GB_PAGE_SHIFT)
+#define GB_CART_RAM_PAGES (0x2000 >> GB_PAGE_SHIFT)
+#define GB_CART_RAM_MAX   0x20000
+#define GB_STATE_PAGES    (GB_PAGES + (GB_CART_RAM_MAX >> GB_PAGE_SHIFT))
+
+#define BLOCK_MAX_UOPS   32
+
+typedef struct {
+    opcode_handler_t handler;
+    uint16_t imm;    /* operand bytes, little-endian */
+    uint8_t opcode;
+    uint8_t length;  /* PC delta */
+    uint8_t cycles;
+} uop_t;
+
+/* Decoded basic block, see BLOCK CACHE in cpu.c */
+typedef struct block_s block_t;
+
+struct block_s {
+    uint16_t start;
+    uint32_t end;    /* one past the last byte decoded */
+    uint16_t home;   /* where start is in its home pages, see bus.h */
+    const uint8_t *source[2]; /* read memory of the first and last page */
+    uint8_t count;
+    bool valid;
+    uint16_t hits;   /* executions while interpreted */
+    dynarec_block_fn native;
+    size_t native_count; /* instructions covered by native */
+    uint16_t native_cycles; /* the most native can take, a branch taken */
+    bool idle;       /* side-effect-free polling loop, see block_idle_loop() */
+    /* leading uops that only touch registers, see run_blocks() */
+    uint8_t prefix;
+    uint16_t prefix_cycles;
+    block_t *next;   /* decoded at the same PC from other memory */
+    block_t *next_home[2]; /* with bytes in the same first and last home page */
+    uop_t uops[];    /* count of them */
+};
+
+typedef struct block_cache_s block_cache_t;
+
+/*
+ * One emulator instance. Everything that changes while running lives in
+ * here and is reached through the gb_t * every function takes, so any
+ * number of instances can run side by side, one thread each. Only the
+ * read-only tables (opcodes[], the generated handler tables) are shared.
+ */
+struct gb_s {
+    registers_t reg;
+    lazy_flags_t flags;
+    bool ime;        /* interrupt master enable */
+    bool halted;     /* waiting in HALT for an interrupt */
+    uint64_t cycles; /* clock cycles executed */
+    bool idle_skip;  /* fast-forward idle loops in cpu_run_cached() */
+    dynarec_t *dynarec; /* translates hot blocks to native code, NULL when off */
+    trace_ring_t *trace; /* binary trace being recorded, NULL when printing */
+    bool trace_print; /* print the text trace when not recording one */
+#if TRACE_LEVEL > TRACE_OFF
+    trace_record_t trace_pending;
+#endif
+    scheduler_t scheduler;
+    io_t io;
+    ppu_t ppu;
+    bus_page_t bus[GB_PAGES];
+    cart_t *cart;    /* inserted cartridge, NULL for none */
+    mbc_t mbc;
+    uint8_t *cart_ram; /* the cartridge's RAM, see mbc.h */
+    size_t cart_ram_size;
+    save_t *save;    /* file cart_ram is kept in, NULL for none */
+    uint64_t save_epoch; /* write epoch of the last save_sync() */
+
+    /* Bumped on every invalidation so a running block can notice it has
+     * overwritten its own code */
+    uint32_t block_generation;
+    /* Bitmap of every address decoded into a cached block, by where it is
+     * in its home page */
+    uint8_t code_bitmap[(0xFFFF + 0x0001) / 8];
+    /* allocated on first use, so instances that never run from the block
+     * cache don't pay for it */
+    block_cache_t *block_cache;
+
+    /* Write epochs: the bus stamps each home page it writes with `epoch`.
+     * To learn what gets written from some point on, start a new epoch
+     * there and later look for pages stamped with it or a later one. */
+    uint64_t page_epoch[GB_PAGES];
+    uint64_t epoch;
+    uint64_t snapshot_base;  /* 0 when RAM isn't relative to any snapshot */
+    uint64_t snapshot_epoch; /* started when snapshot_base was taken or restored */
+    /* The state tree node last captured or loaded and its pages, by id,
+     * see statetree.c */
+    uint64_t tree_node;
+    uint64_t tree_page[GB_STATE_PAGES];
+    uint64_t tree_epoch;
+
+    uint8_t RAM[0xFFFF + 0x0001];
+};
+
+/*
+ * For other runners over the same state, such as lockstep.c. They drive
+ * the instance through these and leave the rest to the usual loops.
+ */
+block_t *cpu_block_at(gb_t *gb, uint16_t pc);
+void cpu_flags_flush(gb_t *gb);
+void cpu_run_block(gb_t *gb, uint64_t until);
+bool cpu_service_events(gb_t *gb);
+void cpu_run_finish(gb_t *gb);
+void cpu_page_load(gb_t *gb, size_t page, const uint8_t *data);
+void cpu_pages_remapped(gb_t *gb);
+
+
+/* Where `address` is in its home page, see bus.h */
+static inline uint16_t gb_home(const gb_t *gb, uint16_t address)
+{
+    return gb->bus[address >> GB_PAGE_SHIFT].home << GB_PAGE_SHIFT |
+	   (address & (GB_PAGE_SIZE - 1));
+}
+
+
+/* The byte at `address`, without the side effects of reading I/O
+ * registers, which give the byte in RAM[] instead. For fetching code. */
+static inline uint8_t gb_peek(const gb_t *gb, uint16_t address)
+{
+    const uint8_t *memory = gb->bus[address >> GB_PAGE_SHIFT].read;
+
+    if (memory)
+	return memory[address & (GB_PAGE_SIZE - 1)];
+    return gb->RAM[gb_home(gb, address)];
+}
+
+
+/* Start a new write epoch, see page_epoch */
+static inline uint64_t gb_epoch_start(gb_t *gb)
+{
+    return ++gb->epoch;
+}
+
+
+/* Pages of the instance's state, those of RAM[] then of cartridge RAM */
+static inline size_t gb_state_pages(const gb_t *gb)
+{
+    return GB_PAGES + (gb->cart_ram_size >> GB_PAGE_SHIFT);
+}
+
+
+static inline const uint8_t *gb_state_page(const gb_t *gb, size_t page)
+{
+    if (page < GB_PAGES)
+	return &gb->RAM[page << GB_PAGE_SHIFT];
+    return &gb->cart_ram[(page - GB_PAGES) << GB_PAGE_SHIFT];
+}
+
+
+/*
+ * Pages of cartridge RAM are stamped at the home page they are seen at,
+ * whichever bank they are in, so the one stamped stands for the same page
+ * of every bank. RAM smaller than a bank repeats every this many pages.
+ */
+static inline size_t gb_cart_ram_span(const gb_t *gb)
+{
+    size_t pages = gb->cart_ram_size >> GB_PAGE_SHIFT;
+
+    return pages < GB_CART_RAM_PAGES ? pages : GB_CART_RAM_PAGES;
+}
+
+
+/* Whether page `page` of the state may have been written since write
+ * epoch `since` */
+static inline bool gb_state_page_written(const gb_t *gb, size_t page, uint64_t since)
+{
+    size_t span;
+
+    if (page < GB_PAGES)
+	return gb->page_epoch[page] >= since;
+    span = gb_cart_ram_span(gb);
+    for (size_t home = (page - GB_PAGES) % span; home < GB_CART_RAM_PAGES; home += span)
+    {
+	if (gb->page_epoch[GB_CART_RAM_PAGE + home] >= since)
+	    return true;
+    }
+    return false;
+}
+
+
+/* Stamp the pages of [start, end) for RAM written other than by the bus */
+static inline void gb_pages_written(gb_t *gb, uint32_t start, uint32_t end)
+{
+    for (uint32_t page = start >> GB_PAGE_SHIFT; page << GB_PAGE_SHIFT < end; page++)
+    {
+	gb->page_epoch[page] = gb->epoch;
+    }
+}
+
+#endif /* __GB_H__ */
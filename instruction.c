@@ -38,6 +38,7 @@ char *instruction_to_string(instruction_e inst)
 	case INST_RET_Z: return "RET Z";
 	case INST_RET_NZ: return "RET NZ";
 	case INST_RET_NC: return "RET NC";
+	case INST_RET_C: return "RET C";
 	case INST_POP: return "POP";
 	case INST_JP: return "JP";
 	case INST_JP_Z: return "JP Z";
@@ -48,6 +49,7 @@ char *instruction_to_string(instruction_e inst)
 	case INST_CALL_Z: return "CALL Z";
 	case INST_CALL_NZ: return "CALL NZ";
 	case INST_CALL_NC: return "CALL NC";
+	case INST_CALL_C: return "CALL C";
 	case INST_PUSH: return "PUSH";
 	case INST_RST: return "RST";
 	case INST_PREFIX: return "PREFIX";
@@ -55,6 +57,17 @@ char *instruction_to_string(instruction_e inst)
 	case INST_DI: return "DI";
 	case INST_EI: return "EI";
 	case INST_HALT: return "HALT";
+	case INST_RLC: return "RLC";
+	case INST_RRC: return "RRC";
+	case INST_RL: return "RL";
+	case INST_RR: return "RR";
+	case INST_SLA: return "SLA";
+	case INST_SRA: return "SRA";
+	case INST_SWAP: return "SWAP";
+	case INST_SRL: return "SRL";
+	case INST_BIT: return "BIT";
+	case INST_RES: return "RES";
+	case INST_SET: return "SET";
 	default: return "UNKNOWN";
     }
 }
@@ -36,6 +36,7 @@ typedef enum {
     INST_RET_Z,
     INST_RET_NZ,
     INST_RET_NC,
+    INST_RET_C,
     INST_POP,
     INST_JP,
     INST_JP_Z,
@@ -46,6 +47,7 @@ typedef enum {
     INST_CALL_Z,
     INST_CALL_NZ,
     INST_CALL_NC,
+    INST_CALL_C,
     INST_PUSH,
     INST_RST,
     INST_PREFIX,
@@ -53,6 +55,18 @@ typedef enum {
     INST_DI,
     INST_EI,
     INST_HALT,
+    /* 0xCB prefixed */
+    INST_RLC,
+    INST_RRC,
+    INST_RL,
+    INST_RR,
+    INST_SLA,
+    INST_SRA,
+    INST_SWAP,
+    INST_SRL,
+    INST_BIT,
+    INST_RES,
+    INST_SET,
 } instruction_e;
 
 char *instruction_to_string(instruction_e inst);
@@ -0,0 +1,442 @@
+#include "io.h"
+
+/*
+ * Timer, LCD timing, serial port, OAM DMA and the interrupt registers.
+ * The lines themselves are drawn by ppu.c, at the start of mode 3.
+ *
+ * Nothing here is ticked per instruction. Values that only count time
+ * (DIV, TIMA) are worked out from the cycle counter when they are read,
+ * and everything that has to happen at a given cycle (TIMA overflow, LCD
+ * mode changes, serial bits, DMA completion) is an event on the
+ * scheduler. Registers with no behaviour yet are plain bytes of guest
+ * memory.
+ *
+ * Known simplifications: TIMA reloads in the same cycle it overflows,
+ * writing DIV doesn't produce the extra TIMA tick real hardware can, and
+ * mode 3 always takes 172 cycles.
+ */
+
+/* T-cycles */
+#define DIV_PERIOD        256
+#define LINE_CYCLES       456
+#define MODE2_CYCLES      80
+#define MODE3_CYCLES      172
+#define MODE0_CYCLES      (LINE_CYCLES - MODE2_CYCLES - MODE3_CYCLES)
+#define SERIAL_BIT_CYCLES 512
+#define DMA_CYCLES        640
+
+#define LCD_LINES         154
+#define LCD_VBLANK_LINE   144
+#define FRAME_CYCLES      (LINE_CYCLES * LCD_LINES)
+
+/* STAT bits */
+#define STAT_MODE         0x03
+#define STAT_COINCIDENCE  0x04
+#define STAT_MODE0_IRQ    0x08
+#define STAT_MODE1_IRQ    0x10
+#define STAT_MODE2_IRQ    0x20
+#define STAT_LYC_IRQ      0x40
+
+#define LCDC_ENABLE       0x80
+#define TAC_ENABLE        0x04
+
+
+static const uint16_t timer_periods[4] = { 1024, 16, 64, 256 };
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+static void interrupt_request(io_t *io, uint8_t interrupt)
+{
+    io->interrupt_flags |= interrupt;
+    scheduler_kick(io->scheduler);
+}
+
+
+/* ======= TIMER ======= */
+static uint64_t timer_period(io_t *io)
+{
+    return timer_periods[io->tac & 3];
+}
+
+
+/* Bring TIMA up to `now`, reloading from TMA on the way if it overflows */
+static void timer_sync(io_t *io, uint64_t now)
+{
+    uint64_t ticks;
+
+    if (now <= io->tima_synced)
+	return;
+    if (io->tac & TAC_ENABLE)
+    {
+	/* TIMA counts falling edges of a divider bit, so ticks line up
+	 * with multiples of the period since the divider was reset */
+	ticks = (now - io->div_base) / timer_period(io) -
+		(io->tima_synced - io->div_base) / timer_period(io);
+	while (ticks >= 0x100u - io->tima)
+	{
+	    ticks -= 0x100u - io->tima;
+	    io->tima = io->tma;
+	}
+	io->tima += ticks;
+    }
+    io->tima_synced = now;
+}
+
+
+static void timer_schedule(io_t *io)
+{
+    uint64_t period = timer_period(io);
+    uint64_t next_tick;
+
+    if (!(io->tac & TAC_ENABLE))
+    {
+	scheduler_cancel(io->scheduler, EVENT_TIMER);
+	return;
+    }
+
+    next_tick = io->div_base + ((io->tima_synced - io->div_base) / period + 1) * period;
+    scheduler_schedule(io->scheduler, EVENT_TIMER, next_tick + (0xFFu - io->tima) * period);
+}
+
+
+static void timer_event(void *context, uint64_t when)
+{
+    io_t *io = context;
+
+    timer_sync(io, when);
+    interrupt_request(io, INTERRUPT_TIMER);
+    timer_schedule(io);
+}
+
+
+/* ======= LCD ======= */
+static void lcd_compare_ly(io_t *io)
+{
+    bool match = io->ly == io->lyc;
+
+    if (match && !(io->stat & STAT_COINCIDENCE) && (io->stat & STAT_LYC_IRQ))
+	interrupt_request(io, INTERRUPT_STAT);
+    io->stat = (io->stat & ~STAT_COINCIDENCE) | (match ? STAT_COINCIDENCE : 0);
+}
+
+
+static void lcd_set_mode(io_t *io, uint8_t mode)
+{
+    static const uint8_t mode_irq[4] = { STAT_MODE0_IRQ, STAT_MODE1_IRQ, STAT_MODE2_IRQ, 0 };
+
+    io->stat = (io->stat & ~STAT_MODE) | mode;
+    if (io->stat & mode_irq[mode])
+	interrupt_request(io, INTERRUPT_STAT);
+}
+
+
+static void lcd_event(void *context, uint64_t when)
+{
+    io_t *io = context;
+
+    switch(io->stat & STAT_MODE)
+    {
+	case 2:
+	{
+	    ppu_render_line(io->ppu, io->memory, io->lcdc, io->ly, &io->window_line);
+	    lcd_set_mode(io, 3);
+	    scheduler_schedule(io->scheduler, EVENT_PPU, when + MODE3_CYCLES);
+	} break;
+	case 3:
+	{
+	    lcd_set_mode(io, 0);
+	    scheduler_schedule(io->scheduler, EVENT_PPU, when + MODE0_CYCLES);
+	} break;
+	case 0:
+	{
+	    io->ly++;
+	    lcd_compare_ly(io);
+	    if (io->ly == LCD_VBLANK_LINE)
+	    {
+		lcd_set_mode(io, 1);
+		interrupt_request(io, INTERRUPT_VBLANK);
+		scheduler_schedule(io->scheduler, EVENT_PPU, when + LINE_CYCLES);
+	    }
+	    else
+	    {
+		lcd_set_mode(io, 2);
+		scheduler_schedule(io->scheduler, EVENT_PPU, when + MODE2_CYCLES);
+	    }
+	} break;
+	case 1:
+	{
+	    if (++io->ly == LCD_LINES)
+	    {
+		io->ly = 0;
+		io->window_line = 0;
+		lcd_compare_ly(io);
+		lcd_set_mode(io, 2);
+		scheduler_schedule(io->scheduler, EVENT_PPU, when + MODE2_CYCLES);
+	    }
+	    else
+	    {
+		lcd_compare_ly(io);
+		scheduler_schedule(io->scheduler, EVENT_PPU, when + LINE_CYCLES);
+	    }
+	} break;
+    }
+}
+
+
+static void lcd_write_lcdc(io_t *io, uint8_t value, uint64_t now)
+{
+    bool was_on = io->lcdc & LCDC_ENABLE;
+
+    io->lcdc = value;
+    if (was_on == !!(value & LCDC_ENABLE))
+	return;
+
+    io->ly = 0;
+    io->window_line = 0;
+    if (value & LCDC_ENABLE)
+    {
+	/* restarts at the top of the frame */
+	io->stat = (io->stat & ~STAT_MODE) | 2;
+	lcd_compare_ly(io);
+	scheduler_schedule(io->scheduler, EVENT_PPU, now + MODE2_CYCLES);
+    }
+    else
+    {
+	io->stat &= ~STAT_MODE;
+	scheduler_cancel(io->scheduler, EVENT_PPU);
+	ppu_blank(io->ppu);
+    }
+}
+
+
+/* ======= SERIAL ======= */
+
+/* Shifts one bit out of SB. There is no link partner, so 1s shift in. */
+static void serial_event(void *context, uint64_t when)
+{
+    io_t *io = context;
+
+    io->sb = (io->sb << 1) | 1;
+    if (++io->serial_bits < 8)
+    {
+	scheduler_schedule(io->scheduler, EVENT_SERIAL, when + SERIAL_BIT_CYCLES);
+	return;
+    }
+    io->sc &= 0x7F;
+    interrupt_request(io, INTERRUPT_SERIAL);
+}
+
+
+static void serial_write_sc(io_t *io, uint8_t value, uint64_t now)
+{
+    io->sc = value | 0x7E;
+    if ((value & 0x81) == 0x81)
+    {
+	/* transfer on the internal clock; an external clock never ticks */
+	io->serial_bits = 0;
+	scheduler_schedule(io->scheduler, EVENT_SERIAL, now + SERIAL_BIT_CYCLES);
+    }
+}
+
+
+/* ======= DMA ======= */
+static void dma_event(void *context, uint64_t when)
+{
+    io_t *io = context;
+    const uint8_t *source = io->bus[io->dma_source].read;
+
+    /* the source never crosses a page; without memory there, the I/O
+     * page, it's what is left in memory */
+    if (!source)
+	source = &io->memory[(uint16_t)io->dma_source << 8];
+    for (uint16_t i = 0; i < 0xA0; i++)
+    {
+	io->memory[0xFE00 + i] = source[i];
+    }
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/* Power-on state with the LCD on at the start of a frame. Registers
+ * outside io_t live in `memory`, events go on `scheduler`, OAM DMA reads
+ * through the page table `bus` and `ppu` draws each line as it starts. */
+void io_reset(io_t *io, scheduler_t *scheduler, uint8_t *memory, const bus_page_t *bus,
+	      ppu_t *ppu, uint64_t now)
+{
+    *io = (io_t){ 0 };
+    io->scheduler = scheduler;
+    io->memory = memory;
+    io->bus = bus;
+    io->ppu = ppu;
+    io->div_base = now;
+    io->tima_synced = now;
+    io->timer_polled = 0;
+    io->sc = 0x7E;
+
+    scheduler_register(scheduler, EVENT_TIMER, timer_event, io);
+    scheduler_register(scheduler, EVENT_PPU, lcd_event, io);
+    scheduler_register(scheduler, EVENT_SERIAL, serial_event, io);
+    scheduler_register(scheduler, EVENT_DMA, dma_event, io);
+
+    lcd_write_lcdc(io, 0x91, now);
+}
+
+
+uint8_t io_read(io_t *io, uint16_t address, uint64_t now)
+{
+    switch(address)
+    {
+	case IO_SB:   return io->sb;
+	case IO_SC:   return io->sc;
+	case IO_DIV:
+	{
+	    io->timer_polled = now;
+	    return (uint8_t)((now - io->div_base) / DIV_PERIOD);
+	}
+	case IO_TIMA:
+	{
+	    io->timer_polled = now;
+	    timer_sync(io, now);
+	    return io->tima;
+	}
+	case IO_TMA:  return io->tma;
+	case IO_TAC:  return io->tac | 0xF8;
+	case IO_IF:   return io->interrupt_flags | 0xE0;
+	case IO_LCDC: return io->lcdc;
+	case IO_STAT: return io->stat | 0x80;
+	case IO_LY:   return io->ly;
+	case IO_LYC:  return io->lyc;
+	case IO_DMA:  return io->dma_source;
+	case IO_IE:   return io->interrupt_enable;
+	default:      return io->memory[address];
+    }
+}
+
+
+void io_write(io_t *io, uint16_t address, uint8_t value, uint64_t now)
+{
+    switch(address)
+    {
+	case IO_SB:   io->sb = value; break;
+	case IO_SC:   serial_write_sc(io, value, now); break;
+	case IO_DIV:
+	{
+	    timer_sync(io, now);
+	    io->div_base = now;
+	    timer_schedule(io);
+	} break;
+	case IO_TIMA:
+	{
+	    timer_sync(io, now);
+	    io->tima = value;
+	    timer_schedule(io);
+	} break;
+	case IO_TMA:
+	{
+	    timer_sync(io, now);
+	    io->tma = value;
+	} break;
+	case IO_TAC:
+	{
+	    timer_sync(io, now);
+	    io->tac = value & 7;
+	    timer_schedule(io);
+	} break;
+	case IO_IF:
+	{
+	    io->interrupt_flags = value & 0x1F;
+	    scheduler_kick(io->scheduler);
+	} break;
+	case IO_LCDC: lcd_write_lcdc(io, value, now); break;
+	case IO_STAT:
+	{
+	    io->stat = (io->stat & (STAT_MODE | STAT_COINCIDENCE)) | (value & 0x78);
+	} break;
+	case IO_LY:   break; /* read only */
+	case IO_LYC:
+	{
+	    io->lyc = value;
+	    if (io->lcdc & LCDC_ENABLE)
+		lcd_compare_ly(io);
+	} break;
+	case IO_DMA:
+	{
+	    io->dma_source = value;
+	    scheduler_schedule(io->scheduler, EVENT_DMA, now + DMA_CYCLES);
+	} break;
+	case IO_IE:
+	{
+	    io->interrupt_enable = value;
+	    scheduler_kick(io->scheduler);
+	} break;
+	default:
+	{
+	    io->memory[address] = value;
+	}
+    }
+}
+
+
+/* Interrupts both requested and enabled */
+uint8_t io_interrupts_pending(const io_t *io)
+{
+    return io->interrupt_flags & io->interrupt_enable & 0x1F;
+}
+
+
+void io_interrupt_ack(io_t *io, uint8_t interrupt)
+{
+    io->interrupt_flags &= ~interrupt;
+}
+
+
+/*
+ * DIV and TIMA change without an event. If either was read at or after
+ * `since`, returns the next cycle one of them changes, otherwise
+ * SCHEDULER_NEVER.
+ */
+uint64_t io_idle_deadline(io_t *io, uint64_t since, uint64_t now)
+{
+    uint64_t period = DIV_PERIOD;
+
+    if (io->timer_polled < since)
+	return SCHEDULER_NEVER;
+    if ((io->tac & TAC_ENABLE) && timer_period(io) < period)
+	period = timer_period(io);
+    return io->div_base + ((now - io->div_base) / period + 1) * period;
+}
+
+
+/*
+ * Cycle the LCD next enters VBlank at, worked out from the current line
+ * and the pending mode change. While the LCD is off there is no VBlank
+ * and a frame's worth of cycles from `now` is returned instead.
+ */
+uint64_t io_next_vblank(const io_t *io, uint64_t now)
+{
+    uint64_t mode_end = io->scheduler->deadline[EVENT_PPU];
+    uint64_t vblank;
+
+    if (!(io->lcdc & LCDC_ENABLE))
+	return now + FRAME_CYCLES;
+
+    switch(io->stat & STAT_MODE)
+    {
+	case 1:
+	{
+	    /* the rest of this VBlank, then a whole frame of visible lines */
+	    vblank = mode_end + (LCD_LINES - 1 - io->ly + LCD_VBLANK_LINE) * LINE_CYCLES;
+	} break;
+	case 2: vblank = mode_end + MODE3_CYCLES + MODE0_CYCLES; break;
+	case 3: vblank = mode_end + MODE0_CYCLES; break;
+	default: vblank = mode_end; break;
+    }
+    if ((io->stat & STAT_MODE) != 1)
+	vblank += (LCD_VBLANK_LINE - 1 - io->ly) * LINE_CYCLES;
+
+    /* the VBlank mode change itself is due but hasn't run yet */
+    if (vblank <= now)
+	vblank += FRAME_CYCLES;
+    return vblank;
+}
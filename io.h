@@ -0,0 +1,81 @@
+#ifndef __IO_H__
+#define __IO_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bus.h"
+#include "ppu.h"
+#include "scheduler.h"
+
+/* Interrupt sources, bits of IF and IE */
+#define INTERRUPT_VBLANK 0x01
+#define INTERRUPT_STAT   0x02
+#define INTERRUPT_TIMER  0x04
+#define INTERRUPT_SERIAL 0x08
+#define INTERRUPT_JOYPAD 0x10
+
+/* Memory-mapped registers handled by io.c */
+#define IO_SB   0xFF01
+#define IO_SC   0xFF02
+#define IO_DIV  0xFF04
+#define IO_TIMA 0xFF05
+#define IO_TMA  0xFF06
+#define IO_TAC  0xFF07
+#define IO_IF   0xFF0F
+#define IO_LCDC 0xFF40
+#define IO_STAT 0xFF41
+#define IO_LY   0xFF44
+#define IO_LYC  0xFF45
+#define IO_DMA  0xFF46
+#define IO_IE   0xFFFF
+
+/* True for addresses that have to go through io_read()/io_write() */
+static inline bool io_address(uint16_t address)
+{
+    return (address >= 0xFF00 && address < 0xFF80) || address == IO_IE;
+}
+
+/* State of the registers above. Lives inside the emulator context, there
+ * is one per instance. */
+typedef struct {
+    scheduler_t *scheduler;
+    uint8_t *memory;     /* guest address space */
+    const bus_page_t *bus; /* where OAM DMA reads from */
+    ppu_t *ppu;          /* draws the lines */
+    uint8_t interrupt_flags;
+    uint8_t interrupt_enable;
+
+    /* timer */
+    uint64_t div_base;   /* cycle the divider was last reset at */
+    uint64_t tima_synced; /* cycle tima is up to date at */
+    uint64_t timer_polled; /* last cycle DIV or TIMA was read */
+    uint8_t tima;
+    uint8_t tma;
+    uint8_t tac;
+
+    /* LCD */
+    uint8_t lcdc;
+    uint8_t stat;        /* interrupt enables, mode and coincidence */
+    uint8_t ly;
+    uint8_t lyc;
+    uint8_t window_line; /* of the window, drawn next */
+
+    /* serial */
+    uint8_t sb;
+    uint8_t sc;
+    uint8_t serial_bits; /* bits shifted in the current transfer */
+
+    uint8_t dma_source;
+} io_t;
+
+void io_reset(io_t *io, scheduler_t *scheduler, uint8_t *memory, const bus_page_t *bus,
+	      ppu_t *ppu, uint64_t now);
+uint8_t io_read(io_t *io, uint16_t address, uint64_t now);
+void io_write(io_t *io, uint16_t address, uint8_t value, uint64_t now);
+uint8_t io_interrupts_pending(const io_t *io);
+void io_interrupt_ack(io_t *io, uint8_t interrupt);
+uint64_t io_idle_deadline(io_t *io, uint64_t since, uint64_t now);
+uint64_t io_next_vblank(const io_t *io, uint64_t now);
+
+#endif /* __IO_H__ */
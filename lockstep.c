@@ -0,0 +1,786 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gb.h"
+#include "io.h"
+#include "lockstep.h"
+
+/*
+ * Each round picks the running lane with the lowest PC and gathers every
+ * lane at that PC that isn't halted, has no event due and holds the same
+ * code there. Running the lowest PC first lets lanes that branched ahead
+ * wait at the join point for the ones still in a loop. The group's
+ * registers are copied into lanes 0..n-1 of a structure-of-arrays register
+ * file, so lanes that went their own way take no part rather than being
+ * masked, then the leader's decoded block is run across them one uop at a
+ * time for as long as the uops are:
+ *
+ *   - 8-bit loads and ALU operations on registers and immediates, INC and
+ *     DEC on 8 and 16-bit registers, CPL, SCF, CCF and NOP
+ *   - the same reading [HL], as long as no lane's HL points at I/O
+ *   - JR and JP, conditional or not, which end the run and may split the
+ *     group in two
+ *
+ * and the group's earliest event isn't due. Anything else is left to each
+ * lane's usual loop, one block per round. Flags are computed eagerly and
+ * the vector part isn't traced, as with the dynarec. Lanes with the
+ * dynarec enabled run native code in their own loop, which ends where the
+ * interpreter would, so they join groups like any other.
+ *
+ * The vector code uses the GCC vector extensions, 32 lanes of 8 bits to a
+ * vector. On x86-64 it is built both for AVX2, one register per vector,
+ * and for the SSE2 baseline, and the loader picks whichever the host runs.
+ * Other compilers run every lane on its own.
+ */
+#define FLAG_Z 0x80
+#define FLAG_N 0x40
+#define FLAG_H 0x20
+#define FLAG_C 0x10
+
+#if defined(__GNUC__)
+#define LOCKSTEP_VECTOR
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define LOCKSTEP_TARGETS __attribute__((target_clones("avx2", "default")))
+#else
+#define LOCKSTEP_TARGETS
+#endif
+
+#ifdef LOCKSTEP_VECTOR
+/* aligned by hand: the baseline build only gives the type 16 bytes, while
+ * the AVX2 clone assumes 32 for whole-vector loads and stores */
+typedef uint8_t lane8_t __attribute__((vector_size(LOCKSTEP_MAX_LANES),
+				       aligned(LOCKSTEP_MAX_LANES)));
+
+/* registers_t inside out: r8[REG8_A] holds the A register of every lane.
+ * SP, PC and IR stay scalar, the lanes of a group share them. */
+typedef struct {
+    lane8_t r8[REG16_SP * 2];
+} lanes_t;
+#endif
+
+/* Blocks whose code was found the same across lanes, see code_lanes() */
+#define LOCKSTEP_VERIFIED 1024
+
+typedef struct {
+    uint16_t start;
+    uint32_t lanes;       /* bits of lanes[] holding the same code */
+    uint64_t generations; /* sum of every lane's block_generation then */
+} verified_t;
+
+struct lockstep_s {
+#ifdef LOCKSTEP_VECTOR
+    lanes_t regs;
+    lane8_t taken;   /* 1 in the lanes that took the branch ending the run */
+#endif
+    gb_t *lanes[LOCKSTEP_MAX_LANES];
+    uint64_t until[LOCKSTEP_MAX_LANES];
+    size_t count;
+    verified_t verified[LOCKSTEP_VERIFIED];
+
+    /* the group of the current round */
+    gb_t *group[LOCKSTEP_MAX_LANES];
+    size_t group_lane[LOCKSTEP_MAX_LANES]; /* index of each in lanes[] */
+    size_t group_count;
+    uint64_t spent;  /* cycles of the last group_run(), every lane */
+    uint16_t pc;     /* PC of the lanes that didn't branch */
+    uint16_t target; /* PC of the lanes that did */
+    uint8_t ir;
+    bool branched;   /* ended on a conditional branch, see taken */
+
+    lockstep_stats_t stats;
+};
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+#ifdef LOCKSTEP_VECTOR
+
+/* 3-bit register operand of an opcode to r8[], 6 is [HL] */
+static const uint8_t operand_r8[8] =
+{
+    REG8_B, REG8_C, REG8_D, REG8_E, REG8_H, REG8_L, 0, REG8_A,
+};
+
+/* 2-bit register pair operand to its high and low r8[], BC, DE and HL */
+static const uint8_t pair_high[3] = { REG8_B, REG8_D, REG8_H };
+static const uint8_t pair_low[3] = { REG8_C, REG8_E, REG8_L };
+
+
+static inline bool lanes_read_hl(lanes_t *regs, gb_t *const *group, size_t count,
+				 lane8_t *value)
+{
+    for (size_t lane = 0; lane < count; lane++)
+    {
+	uint16_t hl = regs->r8[REG8_H][lane] << 8 | regs->r8[REG8_L][lane];
+	const uint8_t *memory = group[lane]->bus[hl >> GB_PAGE_SHIFT].read;
+
+	if (!memory)
+	    return false;
+	(*value)[lane] = memory[hl & (GB_PAGE_SIZE - 1)];
+    }
+    return true;
+}
+
+
+/*
+ * The flags are worked out with bit arithmetic rather than lane compares,
+ * which the baseline x86-64 build would otherwise do a byte at a time.
+ * Carries out of bits 3 and 7 come from the operands and result as in a
+ * full adder, then are shifted to where F keeps them.
+ */
+#define LANES_Z(result)               (~((result) | (0 - (result))) & FLAG_Z)
+#define LANES_CARRY(a, b, result)     (((a) & (b)) | (((a) | (b)) & ~(result)))
+#define LANES_BORROW(a, b, result)    ((~(a) & (b)) | ((~(a) | (b)) & (result)))
+
+
+/* 8-bit ALU operation `alu` from bits 3-5 of the opcode: ADD ADC SUB SBC
+ * AND XOR OR CP */
+static inline void lanes_alu(lanes_t *regs, uint8_t alu, const lane8_t *value)
+{
+    lane8_t a = regs->r8[REG8_A];
+    lane8_t b = *value;
+    lane8_t zero = { 0 };
+    lane8_t carry = (regs->r8[REG8_F] >> 4) & 1;
+    lane8_t result, f;
+
+    if (alu != 1 && alu != 3)
+	carry = zero;
+
+    switch(alu)
+    {
+	case 0:
+	case 1:
+	{
+	    result = a + b + carry;
+	    f = ((((a & 0xF) + (b & 0xF) + carry) & 0x10) << 1) |
+		((LANES_CARRY(a, b, result) >> 3) & FLAG_C);
+	} break;
+	case 2:
+	case 3:
+	case 7:
+	{
+	    result = a - b - carry;
+	    f = FLAG_N | ((((a & 0xF) - (b & 0xF) - carry) & 0x10) << 1) |
+		((LANES_BORROW(a, b, result) >> 3) & FLAG_C);
+	} break;
+	case 4:
+	{
+	    result = a & b;
+	    f = zero | FLAG_H;
+	} break;
+	case 5:
+	{
+	    result = a ^ b;
+	    f = zero;
+	} break;
+	default:
+	{
+	    result = a | b;
+	    f = zero;
+	} break;
+    }
+
+    regs->r8[REG8_F] = f | LANES_Z(result);
+    if (alu != 7)
+	regs->r8[REG8_A] = result;
+}
+
+
+static inline void lanes_inc_dec(lanes_t *regs, uint8_t r, bool dec)
+{
+    lane8_t value = regs->r8[r];
+    lane8_t f = regs->r8[REG8_F] & FLAG_C;
+    lane8_t result;
+
+    if (dec)
+    {
+	result = value - 1;
+	f |= FLAG_N | ((((value & 0xF) - 1) & 0x10) << 1);
+    }
+    else
+    {
+	result = value + 1;
+	f |= (((value & 0xF) + 1) & 0x10) << 1;
+    }
+    regs->r8[REG8_F] = f | LANES_Z(result);
+    regs->r8[r] = result;
+}
+
+
+/* Lanes meeting condition `cc` from bits 3-4 of the opcode, NZ Z NC C,
+ * as 1 in `taken` */
+static inline void lanes_condition(const lanes_t *regs, uint8_t cc, lane8_t *taken)
+{
+    uint8_t shift = cc & 2 ? 4 : 7;
+    uint8_t invert = cc & 1 ? 0 : 1;
+
+    *taken = ((regs->r8[REG8_F] >> shift) & 1) ^ invert;
+}
+
+
+/*
+ * Run the uops of `block` from uops[first] on across the group, from
+ * lockstep->pc, for as long as they can be and while fewer than `slack`
+ * cycles have gone by. Returns the index of the first uop not run,
+ * leaving the outcome in the lockstep_t.
+ */
+static size_t LOCKSTEP_TARGETS group_run(lockstep_t *lockstep, const block_t *block,
+					 size_t first, uint64_t slack)
+{
+    lanes_t *regs = &lockstep->regs;
+    size_t count = lockstep->group_count;
+    size_t run;
+
+    lockstep->spent = 0;
+    lockstep->branched = false;
+
+    for (run = first; run < block->count && lockstep->spent < slack; run++)
+    {
+	const uop_t *uop = &block->uops[run];
+	uint8_t op = uop->opcode;
+	uint8_t x = (op >> 3) & 7;
+	uint8_t y = op & 7;
+	uint16_t next = lockstep->pc + uop->length;
+	lane8_t value = { 0 };
+	bool last = false;
+
+	if (op >= 0x40 && op < 0xC0 && op != 0x76 && !(op < 0x80 && x == 6))
+	{
+	    /* LD r, r and ALU A, r */
+	    if (y == 6)
+	    {
+		if (!lanes_read_hl(regs, lockstep->group, count, &value))
+		    break;
+	    }
+	    else
+	    {
+		value = regs->r8[operand_r8[y]];
+	    }
+
+	    if (op < 0x80)
+		regs->r8[operand_r8[x]] = value;
+	    else
+		lanes_alu(regs, x, &value);
+	}
+	else if ((op & 0xC7) == 0xC6)
+	{
+	    value += (uint8_t)uop->imm;
+	    lanes_alu(regs, x, &value);
+	}
+	else if ((op & 0xC7) == 0x06 && x != 6)
+	{
+	    regs->r8[operand_r8[x]] = value + (uint8_t)uop->imm;
+	}
+	else if ((op & 0xC6) == 0x04 && x != 6)
+	{
+	    lanes_inc_dec(regs, operand_r8[x], op & 1);
+	}
+	else if ((op & 0xC7) == 0x03 && op != 0x33 && op != 0x3B)
+	{
+	    /* INC rr and DEC rr, no flags */
+	    uint8_t high = pair_high[op >> 4];
+	    uint8_t low = pair_low[op >> 4];
+	    lane8_t before = regs->r8[low];
+
+	    if (op & 0x08)
+	    {
+		regs->r8[low] = before - 1;
+		regs->r8[high] -= LANES_Z(before) >> 7;
+	    }
+	    else
+	    {
+		regs->r8[low] = before + 1;
+		regs->r8[high] += LANES_Z(regs->r8[low]) >> 7;
+	    }
+	}
+	else
+	{
+	    switch(op)
+	    {
+		case 0x00:
+		    break;
+		case 0x2F:
+		{
+		    regs->r8[REG8_A] = ~regs->r8[REG8_A];
+		    regs->r8[REG8_F] |= FLAG_N | FLAG_H;
+		} break;
+		case 0x37:
+		{
+		    regs->r8[REG8_F] = (regs->r8[REG8_F] & FLAG_Z) | FLAG_C;
+		} break;
+		case 0x3F:
+		{
+		    regs->r8[REG8_F] = (regs->r8[REG8_F] & (FLAG_Z | FLAG_C)) ^ FLAG_C;
+		} break;
+		case 0x18:
+		{
+		    next += (int8_t)uop->imm;
+		    last = true;
+		} break;
+		case 0xC3:
+		{
+		    next = uop->imm;
+		    last = true;
+		} break;
+		case 0x20: case 0x28: case 0x30: case 0x38:
+		{
+		    lanes_condition(regs, x & 3, &lockstep->taken);
+		    lockstep->target = next + (int8_t)uop->imm;
+		    lockstep->branched = true;
+		    last = true;
+		} break;
+		case 0xC2: case 0xCA: case 0xD2: case 0xDA:
+		{
+		    lanes_condition(regs, x & 3, &lockstep->taken);
+		    lockstep->target = uop->imm;
+		    lockstep->branched = true;
+		    last = true;
+		} break;
+		default:
+		    goto stop;
+	    }
+	}
+
+	lockstep->pc = next;
+	lockstep->ir = op;
+	lockstep->spent += uop->cycles;
+	if (last)
+	{
+	    run++;
+	    break;
+	}
+    }
+
+stop:
+    return run;
+}
+
+
+static void group_gather(lockstep_t *lockstep)
+{
+    for (size_t lane = 0; lane < lockstep->group_count; lane++)
+    {
+	gb_t *gb = lockstep->group[lane];
+
+	cpu_flags_flush(gb);
+	for (int r = 0; r < REG16_SP * 2; r++)
+	{
+	    lockstep->regs.r8[r][lane] = gb->reg.r8[r];
+	}
+    }
+}
+
+
+/* Write the group back after `spent` more cycles, F included, which
+ * leaves no flags pending */
+static void group_scatter(lockstep_t *lockstep, uint64_t spent)
+{
+    for (size_t lane = 0; lane < lockstep->group_count; lane++)
+    {
+	gb_t *gb = lockstep->group[lane];
+	bool taken = lockstep->branched && lockstep->taken[lane];
+
+	for (int r = 0; r < REG16_SP * 2; r++)
+	{
+	    gb->reg.r8[r] = lockstep->regs.r8[r][lane];
+	}
+	gb->reg.PC = taken ? lockstep->target : lockstep->pc;
+	gb->reg.IR = lockstep->ir;
+	/* a conditional branch taken costs one more M-cycle */
+	gb->cycles += spent + (taken ? 4 : 0);
+    }
+}
+
+
+/* Write one lane back, PC aside, and move the last lane into its place */
+static void group_drop(lockstep_t *lockstep, size_t lane)
+{
+    gb_t *gb = lockstep->group[lane];
+    size_t last = --lockstep->group_count;
+
+    for (int r = 0; r < REG16_SP * 2; r++)
+    {
+	gb->reg.r8[r] = lockstep->regs.r8[r][lane];
+	lockstep->regs.r8[r][lane] = lockstep->regs.r8[r][last];
+    }
+    gb->reg.IR = lockstep->ir;
+    lockstep->taken[lane] = lockstep->taken[last];
+    lockstep->group[lane] = lockstep->group[last];
+    lockstep->group_lane[lane] = lockstep->group_lane[last];
+}
+
+
+/*
+ * After a conditional branch that only some lanes took, charge the group
+ * the `spent` cycles run so far and keep the side with the lower PC, which
+ * would be run next anyway. The other side leaves the group.
+ */
+static void group_split(lockstep_t *lockstep, uint64_t spent)
+{
+    bool keep = lockstep->target < lockstep->pc;
+    size_t lane = 0;
+
+    while (lane < lockstep->group_count)
+    {
+	gb_t *gb = lockstep->group[lane];
+	bool taken = lockstep->taken[lane];
+
+	gb->cycles += spent + (taken ? 4 : 0);
+	if (taken == keep)
+	{
+	    lane++;
+	    continue;
+	}
+	gb->reg.PC = taken ? lockstep->target : lockstep->pc;
+	group_drop(lockstep, lane);
+    }
+    if (keep)
+	lockstep->pc = lockstep->target;
+    lockstep->branched = false;
+}
+
+
+/* Cycles until the first lane of the group is due an event */
+static uint64_t group_slack(const lockstep_t *lockstep)
+{
+    uint64_t slack = UINT64_MAX;
+
+    for (size_t lane = 0; lane < lockstep->group_count; lane++)
+    {
+	gb_t *gb = lockstep->group[lane];
+
+	if (gb->scheduler.next <= gb->cycles)
+	    return 0;
+	if (gb->scheduler.next - gb->cycles < slack)
+	    slack = gb->scheduler.next - gb->cycles;
+    }
+    return slack;
+}
+
+
+/*
+ * Charge the group the `spent` cycles run so far, then service the lanes
+ * that are due an event at lockstep->pc, as their own loop would. Lanes
+ * at the end of their run, halted or sent to an interrupt handler leave
+ * the group.
+ */
+static void group_service(lockstep_t *lockstep, uint64_t spent)
+{
+    size_t lane;
+
+    for (lane = 0; lane < lockstep->group_count; lane++)
+    {
+	lockstep->group[lane]->cycles += spent;
+    }
+
+    lane = 0;
+    while (lane < lockstep->group_count)
+    {
+	gb_t *gb = lockstep->group[lane];
+
+	gb->reg.PC = lockstep->pc;
+	if (gb->cycles < gb->scheduler.next)
+	{
+	    lane++;
+	    continue;
+	}
+	if (gb->cycles < lockstep->until[lockstep->group_lane[lane]] &&
+	    !cpu_service_events(gb) && gb->reg.PC == lockstep->pc)
+	{
+	    lane++;
+	    continue;
+	}
+	group_drop(lockstep, lane);
+    }
+}
+#endif /* LOCKSTEP_VECTOR */
+
+
+static uint64_t lane_generations(const lockstep_t *lockstep)
+{
+    uint64_t generations = 0;
+
+    for (size_t i = 0; i < lockstep->count; i++)
+    {
+	generations += lockstep->lanes[i]->block_generation;
+    }
+    return generations;
+}
+
+
+/* Whether two lanes decoded the same instructions */
+static bool same_code(const block_t *a, const block_t *b)
+{
+    if (a->count != b->count || a->end != b->end)
+	return false;
+    for (size_t i = 0; i < a->count; i++)
+    {
+	if (a->uops[i].opcode != b->uops[i].opcode || a->uops[i].imm != b->uops[i].imm)
+	    return false;
+    }
+    return true;
+}
+
+
+/*
+ * The lanes, as bits of lanes[], holding the same code as lanes[reference]
+ * over `block`. Each lane's own decoding of the block is compared, which
+ * marks the bytes as code so that rewriting any of them bumps its block
+ * generation. Until one does the answer is taken from the cache.
+ */
+static uint32_t code_lanes(lockstep_t *lockstep, size_t reference, const block_t *block,
+			   uint64_t generations)
+{
+    verified_t *verified = &lockstep->verified[block->start & (LOCKSTEP_VERIFIED - 1)];
+
+    if (verified->start == block->start && verified->generations == generations &&
+	(verified->lanes & (1u << reference)))
+    {
+	return verified->lanes;
+    }
+
+    verified->start = block->start;
+    verified->generations = generations;
+    verified->lanes = 1u << reference;
+    for (size_t i = 0; i < lockstep->count; i++)
+    {
+	gb_t *gb = lockstep->lanes[i];
+	const block_t *own;
+
+	if (i != reference && (own = cpu_block_at(gb, block->start)) && same_code(own, block))
+	{
+	    verified->lanes |= 1u << i;
+	}
+    }
+    return verified->lanes;
+}
+
+
+#ifdef LOCKSTEP_VECTOR
+/*
+ * Run the group from `block` on for as long as it stays together: across
+ * blocks while the lanes branch the same way and the code matches, and
+ * across events that leave the lanes where they were. Returns the number
+ * of instructions run.
+ */
+static size_t group_vector(lockstep_t *lockstep, const block_t *block, uint64_t generations)
+{
+    uint64_t slack = group_slack(lockstep);
+    uint64_t spent = 0;
+    size_t executed = 0;
+    size_t first = 0;
+
+    lockstep->pc = block->start;
+    group_gather(lockstep);
+    while (slack)
+    {
+	size_t run = group_run(lockstep, block, first, slack - spent);
+	uint32_t group_mask = 0;
+	size_t reference;
+
+	executed += run - first;
+	lockstep->stats.vector_lane_instructions += (run - first) * lockstep->group_count;
+	spent += lockstep->spent;
+	first = run;
+
+	if (run == block->count && lockstep->branched)
+	{
+	    size_t taken = 0;
+
+	    for (size_t lane = 0; lane < lockstep->group_count; lane++)
+	    {
+		taken += lockstep->taken[lane];
+	    }
+	    if (taken == lockstep->group_count)
+	    {
+		lockstep->pc = lockstep->target;
+		spent += 4;
+	    }
+	    else if (taken)
+	    {
+		group_split(lockstep, spent);
+		spent = 0;
+		slack = group_slack(lockstep);
+		if (lockstep->group_count < 2)
+		    break;
+	    }
+	    lockstep->branched = false;
+	}
+
+	if (spent >= slack)
+	{
+	    /* a lane is due an event, the others carry on with it if they can */
+	    group_service(lockstep, spent);
+	    spent = 0;
+	    slack = group_slack(lockstep);
+	    if (lockstep->group_count < 2)
+		break;
+	    if (run < block->count)
+		continue;
+	}
+	else if (run < block->count)
+	{
+	    break;
+	}
+
+	for (size_t lane = 0; lane < lockstep->group_count; lane++)
+	{
+	    group_mask |= 1u << lockstep->group_lane[lane];
+	}
+	reference = lockstep->group_lane[0];
+	block = cpu_block_at(lockstep->lanes[reference], lockstep->pc);
+	if (!block || (code_lanes(lockstep, reference, block, generations) & group_mask) != group_mask)
+	    break;
+	first = 0;
+    }
+
+    if (executed)
+	group_scatter(lockstep, spent);
+    return executed;
+}
+#endif /* LOCKSTEP_VECTOR */
+
+
+/*
+ * Run the lanes at the leader's PC for a round. Lanes that can't join the
+ * group only run once the group is done, as they may write to the code
+ * the group was checked against.
+ */
+static void run_group(lockstep_t *lockstep, size_t leader)
+{
+    uint16_t pc = lockstep->lanes[leader]->reg.PC;
+    block_t *block = cpu_block_at(lockstep->lanes[leader], pc);
+    uint64_t generations = lane_generations(lockstep);
+    uint32_t code = block ? code_lanes(lockstep, leader, block, generations) : 0;
+    size_t solo[LOCKSTEP_MAX_LANES];
+    size_t solo_count = 0;
+    size_t run = 0;
+
+    lockstep->group_count = 0;
+    for (size_t i = 0; i < lockstep->count; i++)
+    {
+	gb_t *gb = lockstep->lanes[i];
+
+	if (gb->cycles >= lockstep->until[i] || gb->halted || gb->reg.PC != pc)
+	    continue;
+	if (gb->cycles >= gb->scheduler.next || !(code & (1u << i)))
+	{
+	    /* due an event, or the code differs */
+	    solo[solo_count++] = i;
+	    continue;
+	}
+	lockstep->group_lane[lockstep->group_count] = i;
+	lockstep->group[lockstep->group_count++] = gb;
+    }
+
+#ifdef LOCKSTEP_VECTOR
+    if (lockstep->group_count > 1)
+    {
+	run = group_vector(lockstep, block, generations);
+	lockstep->stats.vector_instructions += run;
+    }
+#endif
+    if (!run)
+    {
+	for (size_t lane = 0; lane < lockstep->group_count; lane++)
+	{
+	    solo[solo_count++] = lockstep->group_lane[lane];
+	}
+    }
+
+    for (size_t i = 0; i < solo_count; i++)
+    {
+	cpu_run_block(lockstep->lanes[solo[i]], lockstep->until[solo[i]]);
+	lockstep->stats.scalar_blocks++;
+    }
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/*
+ * A lockstep runner over `count` instances, at most LOCKSTEP_MAX_LANES.
+ * The instances stay the caller's and can still be run on their own in
+ * between. NULL if there are too many or out of memory.
+ */
+lockstep_t *lockstep_create(gb_t *const *lanes, size_t count)
+{
+    lockstep_t *lockstep;
+
+    if (count == 0 || count > LOCKSTEP_MAX_LANES)
+	return NULL;
+    lockstep = aligned_alloc(_Alignof(lockstep_t), sizeof(lockstep_t));
+    if (!lockstep)
+	return NULL;
+
+    memset(lockstep, 0, sizeof(lockstep_t));
+    memcpy(lockstep->lanes, lanes, count * sizeof(gb_t *));
+    lockstep->count = count;
+    return lockstep;
+}
+
+
+void lockstep_free(lockstep_t *lockstep)
+{
+    free(lockstep);
+}
+
+
+/* cpu_run_cycles(lane, cycles) on every lane */
+void lockstep_run_cycles(lockstep_t *lockstep, uint64_t cycles)
+{
+    if (cycles == 0)
+	return;
+
+    for (size_t i = 0; i < lockstep->count; i++)
+    {
+	gb_t *gb = lockstep->lanes[i];
+
+	lockstep->until[i] = gb->cycles + cycles;
+	scheduler_schedule(&gb->scheduler, EVENT_RUN_END, lockstep->until[i]);
+    }
+
+    for (;;)
+    {
+	gb_t *leader = NULL;
+	size_t leader_index = 0;
+	bool running = false;
+
+	for (size_t i = 0; i < lockstep->count; i++)
+	{
+	    gb_t *gb = lockstep->lanes[i];
+
+	    if (gb->cycles >= lockstep->until[i])
+		continue;
+	    running = true;
+	    if (gb->halted)
+	    {
+		cpu_run_block(gb, lockstep->until[i]);
+		lockstep->stats.scalar_blocks++;
+	    }
+	    else if (!leader || gb->reg.PC < leader->reg.PC)
+	    {
+		leader = gb;
+		leader_index = i;
+	    }
+	}
+
+	if (!running)
+	    break;
+	if (leader)
+	    run_group(lockstep, leader_index);
+    }
+
+    for (size_t i = 0; i < lockstep->count; i++)
+    {
+	cpu_run_finish(lockstep->lanes[i]);
+    }
+}
+
+
+void lockstep_stats(const lockstep_t *lockstep, lockstep_stats_t *stats)
+{
+    *stats = lockstep->stats;
+}
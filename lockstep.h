@@ -0,0 +1,33 @@
+#ifndef __LOCKSTEP_H__
+#define __LOCKSTEP_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+/*
+ * Runs a group of instances in lockstep, for many copies of one ROM fed
+ * different inputs. Wherever lanes share a PC and the code there, each
+ * instruction of a register-only run is decoded once and executed for all
+ * of them on a structure-of-arrays register file, a SIMD lane per
+ * instance. Lanes that branch apart are run separately until they meet
+ * again, and anything else runs on each lane's usual loop. Every lane ends
+ * up exactly where cpu_run_cycles() would have left it.
+ */
+#define LOCKSTEP_MAX_LANES 32
+
+typedef struct lockstep_s lockstep_t;
+
+typedef struct {
+    uint64_t vector_instructions;      /* decoded once for a group of lanes */
+    uint64_t vector_lane_instructions; /* the above, times the lanes in the group */
+    uint64_t scalar_blocks;            /* blocks run by a lane on its own */
+} lockstep_stats_t;
+
+lockstep_t *lockstep_create(gb_t *const *lanes, size_t count);
+void lockstep_free(lockstep_t *lockstep);
+void lockstep_run_cycles(lockstep_t *lockstep, uint64_t cycles);
+void lockstep_stats(const lockstep_t *lockstep, lockstep_stats_t *stats);
+
+#endif /* __LOCKSTEP_H__ */
@@ -1,22 +1,355 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
+#include "batch.h"
 #include "cpu.h"
+#include "emu.h"
+#include "forkserver.h"
+#include "lockstep.h"
 
 
+static int run_batch(const char *manifest, const batch_options_t *options,
+		     batch_format_e format)
+{
+    batch_t *batch = batch_load(manifest);
+
+    if (!batch)
+	return 1;
+    if (!batch_run(batch, options))
+    {
+	fprintf(stderr, "failed to start the batch workers\n");
+	batch_free(batch);
+	return 1;
+    }
+    batch_write(batch, stdout, format);
+    batch_free(batch);
+    return 0;
+}
+
+
+/* `count` copies of the ROM, or of the built-in program, run for `frames`
+ * frames' worth of cycles in lockstep, and a CSV line per lane of how it
+ * ended */
+static int run_lockstep(const char *rom, long count, long frames, bool dynarec,
+			bool idle_skip)
+{
+    gb_t *lanes[LOCKSTEP_MAX_LANES] = { NULL };
+    lockstep_t *lockstep = NULL;
+    lockstep_stats_t stats;
+    struct timespec start, end;
+    int status = 1;
+
+    for (long i = 0; i < count; i++)
+    {
+	lanes[i] = gb_alloc();
+	if (!lanes[i])
+	{
+	    fprintf(stderr, "out of memory\n");
+	    goto done;
+	}
+	cpu_set_trace_print(lanes[i], false);
+	cpu_set_idle_skip(lanes[i], idle_skip);
+	if (dynarec && !cpu_set_dynarec(lanes[i], true) && i == 0)
+	    fprintf(stderr, "dynarec is not available on this host\n");
+	if (rom && !emu_load_rom(lanes[i], rom))
+	{
+	    fprintf(stderr, "%s: failed to read the ROM\n", rom);
+	    goto done;
+	}
+    }
+    lockstep = lockstep_create(lanes, count);
+    if (!lockstep)
+    {
+	fprintf(stderr, "out of memory\n");
+	goto done;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long frame = 0; frame < frames; frame++)
+    {
+	lockstep_run_cycles(lockstep, EMU_FRAME_CYCLES);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    printf("lane,cycles,hash\n");
+    for (long i = 0; i < count; i++)
+    {
+	printf("%ld,%llu,%016llx\n", i, (unsigned long long)cpu_cycles(lanes[i]),
+	       (unsigned long long)cpu_state_hash(lanes[i]));
+    }
+    lockstep_stats(lockstep, &stats);
+    fprintf(stderr, "%.6f s, %llu instructions decoded once for %llu lane instructions,"
+	    " %llu blocks run by a lane alone\n",
+	    (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9,
+	    (unsigned long long)stats.vector_instructions,
+	    (unsigned long long)stats.vector_lane_instructions,
+	    (unsigned long long)stats.scalar_blocks);
+    status = 0;
+
+done:
+    lockstep_free(lockstep);
+    for (long i = 0; i < count; i++)
+    {
+	gb_free(lanes[i]);
+    }
+    return status;
+}
+
+
+/* The screen as a binary PGM image, the LCD's 4 shades as gray levels */
+static bool write_screenshot(gb_t *gb, const char *path)
+{
+    const uint8_t *framebuffer = emu_framebuffer(gb);
+    uint8_t pixels[PPU_WIDTH * PPU_HEIGHT];
+    FILE *file = fopen(path, "wb");
+    bool written;
+
+    if (!file)
+	return false;
+    for (size_t i = 0; i < sizeof(pixels); i++)
+    {
+	pixels[i] = 3 - framebuffer[i];
+    }
+    written = fprintf(file, "P5\n%d %d\n3\n", PPU_WIDTH, PPU_HEIGHT) > 0 &&
+	      fwrite(pixels, sizeof(pixels), 1, file) == 1;
+    return fclose(file) == 0 && written;
+}
+
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "usage: %s [--rom FILE [--save FILE] [--rtc-realtime]] [--dynarec]"
+	    " [--no-idle-skip] [--frames N] [--screenshot FILE] [--trace FILE [--trace-drop]]\n",
+	    program);
+    fprintf(stderr, "       %s --batch MANIFEST [--threads N] [--json] [--no-pin]"
+	    " [--dynarec] [--no-idle-skip]\n", program);
+    fprintf(stderr, "       %s --serve SOCKET [--rom FILE] [--frames N] [--threads N]"
+	    " [--dynarec] [--no-idle-skip]\n", program);
+    fprintf(stderr, "       %s --lockstep LANES [--rom FILE] --frames N"
+	    " [--dynarec] [--no-idle-skip]\n", program);
+    fprintf(stderr, "  --rom FILE      run the ROM in FILE instead of the built-in program\n");
+    fprintf(stderr, "  --save FILE     keep the cartridge's RAM in FILE, created if missing\n");
+    fprintf(stderr, "  --rtc-realtime  run the cartridge's clock off the host's clock\n");
+    fprintf(stderr, "  --dynarec       translate hot blocks to native code\n");
+    fprintf(stderr, "  --no-idle-skip  run idle loops instead of fast-forwarding them\n");
+    fprintf(stderr, "  --frames N      run N video frames instead of 10 instructions\n");
+    fprintf(stderr, "  --screenshot FILE\n");
+    fprintf(stderr, "                  write the screen to FILE as a PGM image at the end\n");
+    fprintf(stderr, "  --trace FILE    record the execution trace to FILE in binary,\n");
+    fprintf(stderr, "                  read it back with tools/trace_decode\n");
+    fprintf(stderr, "  --trace-drop    drop trace records rather than wait when the\n");
+    fprintf(stderr, "                  writer falls behind\n");
+    fprintf(stderr, "  --batch FILE    run the jobs listed in FILE, one `ROM FRAMES` per\n");
+    fprintf(stderr, "                  line, and print a CSV line of results per job\n");
+    fprintf(stderr, "  --threads N     batch worker threads, one per CPU by default\n");
+    fprintf(stderr, "  --json          print batch results as JSON instead\n");
+    fprintf(stderr, "  --no-pin        leave batch workers unpinned\n");
+    fprintf(stderr, "  --serve SOCKET  run --frames N frames, then fork a child per `ID FRAMES`\n");
+    fprintf(stderr, "                  job line on the Unix socket SOCKET, or on stdin for -,\n");
+    fprintf(stderr, "                  each starting from there; --threads N jobs at once\n");
+    fprintf(stderr, "  --lockstep LANES\n");
+    fprintf(stderr, "                  run LANES copies, up to %d, for N frames in lockstep\n",
+	    LOCKSTEP_MAX_LANES);
+    fprintf(stderr, "                  and print a CSV line of results per lane\n");
+}
 
 
 int main (int argc, char **argv)
 {
-    cpu_init();
-    for (size_t i = 0; i < 10; ++i) {
-	cpu_fetch();
-	cpu_execute();
+    bool dynarec = false;
+    bool idle_skip = true;
+    const char *trace_path = NULL;
+    const char *screenshot = NULL;
+    bool trace_drop = false;
+    long frames = 0;
+    const char *manifest = NULL;
+    const char *rom = NULL;
+    const char *save_path = NULL;
+    bool rtc_realtime = false;
+    const char *serve = NULL;
+    long lanes = 0;
+    batch_options_t batch_options = { .pin = true };
+    batch_format_e batch_format = BATCH_FORMAT_CSV;
+    gb_t *gb;
+
+    for (int i = 1; i < argc; i++)
+    {
+	if (strcmp(argv[i], "--dynarec") == 0)
+	{
+	    dynarec = true;
+	}
+	else if (strcmp(argv[i], "--no-idle-skip") == 0)
+	{
+	    idle_skip = false;
+	}
+	else if (strcmp(argv[i], "--rom") == 0 && i + 1 < argc)
+	{
+	    rom = argv[++i];
+	}
+	else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+	{
+	    save_path = argv[++i];
+	}
+	else if (strcmp(argv[i], "--rtc-realtime") == 0)
+	{
+	    rtc_realtime = true;
+	}
+	else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc)
+	{
+	    serve = argv[++i];
+	}
+	else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+	{
+	    frames = strtol(argv[++i], NULL, 0);
+	}
+	else if (strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc)
+	{
+	    screenshot = argv[++i];
+	}
+	else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+	{
+	    trace_path = argv[++i];
+	}
+	else if (strcmp(argv[i], "--trace-drop") == 0)
+	{
+	    trace_drop = true;
+	}
+	else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+	{
+	    manifest = argv[++i];
+	}
+	else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+	{
+	    batch_options.threads = (int)strtol(argv[++i], NULL, 0);
+	}
+	else if (strcmp(argv[i], "--json") == 0)
+	{
+	    batch_format = BATCH_FORMAT_JSON;
+	}
+	else if (strcmp(argv[i], "--no-pin") == 0)
+	{
+	    batch_options.pin = false;
+	}
+	else if (strcmp(argv[i], "--lockstep") == 0 && i + 1 < argc)
+	{
+	    lanes = strtol(argv[++i], NULL, 0);
+	    if (lanes < 1 || lanes > LOCKSTEP_MAX_LANES)
+	    {
+		usage(argv[0]);
+		return 1;
+	    }
+	}
+	else
+	{
+	    usage(argv[0]);
+	    return 1;
+	}
+    }
+
+    /* the trace writer and save syncer threads wouldn't survive the fork,
+     * and the jobs would all write the one save file */
+    if ((serve && (trace_path || save_path)) || (save_path && !rom))
+    {
+	usage(argv[0]);
+	return 1;
+    }
+    /* lanes run by the cycle, and share neither a trace nor a save */
+    if (lanes && (frames <= 0 || trace_path || save_path || serve))
+    {
+	usage(argv[0]);
+	return 1;
+    }
+
+    if (lanes)
+	return run_lockstep(rom, lanes, frames, dynarec, idle_skip);
+
+    if (manifest)
+    {
+	batch_options.dynarec = dynarec;
+	batch_options.idle_skip = idle_skip;
+	return run_batch(manifest, &batch_options, batch_format);
     }
 
-    cpu_print_state();
+    gb = gb_alloc();
+    if (!gb)
+    {
+	fprintf(stderr, "out of memory\n");
+	return 1;
+    }
+    cpu_set_idle_skip(gb, idle_skip);
+    if (dynarec && !cpu_set_dynarec(gb, true))
+    {
+	fprintf(stderr, "dynarec is not available on this host\n");
+    }
+    if (rom && !emu_load_rom(gb, rom))
+    {
+	fprintf(stderr, "%s: failed to read the ROM\n", rom);
+	gb_free(gb);
+	return 1;
+    }
+    if (rtc_realtime)
+	emu_set_rtc_realtime(gb, true);
+    if (save_path && !emu_attach_save(gb, save_path))
+    {
+	fprintf(stderr, "%s: failed to map the save file, or the cartridge has no RAM\n",
+		save_path);
+	gb_free(gb);
+	return 1;
+    }
+    if (serve)
+    {
+	forkserver_options_t serve_options = {
+	    .socket_path = strcmp(serve, "-") != 0 ? serve : NULL,
+	    .jobs = batch_options.threads,
+	};
+	bool served;
+
+	cpu_set_trace_print(gb, false);
+	for (long frame = 0; frame < frames; frame++)
+	{
+	    emu_run_frame(gb);
+	}
+	served = forkserver_run(gb, &serve_options);
+	gb_free(gb);
+	return served ? 0 : 1;
+    }
+    if (trace_path && !cpu_trace_start(gb, trace_path, trace_drop))
+    {
+	fprintf(stderr, "failed to start the trace to %s\n", trace_path);
+	gb_free(gb);
+	return 1;
+    }
+    if (frames > 0)
+    {
+	for (long frame = 0; frame < frames; frame++)
+	{
+	    emu_run_frame(gb);
+	}
+    }
+    else
+    {
+	cpu_run_cached(gb, 10);
+    }
+    if (trace_path)
+    {
+	uint64_t dropped = cpu_trace_stop(gb);
+	if (dropped)
+	    fprintf(stderr, "%llu trace records dropped\n", (unsigned long long)dropped);
+    }
+
+    if (screenshot && !write_screenshot(gb, screenshot))
+    {
+	fprintf(stderr, "failed to write the screenshot to %s\n", screenshot);
+	gb_free(gb);
+	return 1;
+    }
 
+    cpu_print_state(gb);
+    gb_free(gb);
 
     return 0;
 }
@@ -0,0 +1,436 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "bus.h"
+#include "cart.h"
+#include "gb.h"
+#include "mbc.h"
+#include "save.h"
+
+/*
+ * Every register write works out the banks the registers select and only
+ * repoints the pages of the bus whose memory changes, so games that write
+ * the same bank over and over don't throw away decoded blocks.
+ */
+#define MBC_ROM_PAGES     (CART_BANK_SIZE >> GB_PAGE_SHIFT)
+#define MBC_RAM_PAGE      (0xA000 >> GB_PAGE_SHIFT)
+#define MBC_RAM_PAGES     (0x2000 >> GB_PAGE_SHIFT)
+#define MBC_RAM_BANK_SIZE 0x2000
+
+/*
+ * The clock is a count of ticks, cycles or host nanoseconds, brought up
+ * to date by rtc_sync() with whatever went by since, unless halted. Its
+ * registers are the count in seconds split into days, hours, minutes and
+ * seconds; what is left is the part of a second that has gone by, which
+ * writing the seconds resets. Past 512 days the count wraps and the carry
+ * flag is set until written back to 0. A register written out of range
+ * carries into the next one at once rather than when it next ticks.
+ */
+#define RTC_CYCLES_PER_SECOND 4194304
+#define RTC_NS_PER_SECOND     1000000000ULL
+#define RTC_SECONDS_PER_DAY   86400
+#define RTC_DAYS              512
+
+enum {
+    RTC_S,
+    RTC_M,
+    RTC_H,
+    RTC_DL,
+    RTC_DH,
+};
+
+#define RTC_DH_DAY   0x01
+#define RTC_DH_HALT  0x40
+#define RTC_DH_CARRY 0x80
+
+/* Writable bits of the clock registers */
+static const uint8_t rtc_masks[MBC3_RTC_COUNT] = { 0x3F, 0x3F, 0x1F, 0xFF, 0xC1 };
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+static mbc_kind_e mbc_kind(uint8_t type)
+{
+    if (type >= 0x01 && type <= 0x03)
+	return MBC_1;
+    if (type >= 0x0F && type <= 0x13)
+	return MBC_3;
+    if (type >= 0x19 && type <= 0x1E)
+	return MBC_5;
+    return MBC_NONE;
+}
+
+
+/* The ROM banks the registers put at 0x0000 and 0x4000 */
+static void rom_banks(const mbc_t *mbc, size_t *low, size_t *high)
+{
+    *low = 0;
+    switch(mbc->kind)
+    {
+	case MBC_1:
+	{
+	    /* in mode 1 the upper bits also bank 0x0000 */
+	    size_t upper = (size_t)mbc->ram_bank << 5;
+
+	    *low = mbc->mode ? upper : 0;
+	    *high = upper | (mbc->rom_bank ? mbc->rom_bank : 1);
+	} break;
+	case MBC_3:   *high = mbc->rom_bank ? mbc->rom_bank : 1; break;
+	case MBC_5:   *high = mbc->rom_bank; break;
+	default:      *high = 1; break;
+    }
+}
+
+
+static void map_rom(gb_t *gb)
+{
+    const uint8_t *memory;
+    size_t low, high;
+
+    rom_banks(&gb->mbc, &low, &high);
+    memory = cart_bank(gb->cart, low);
+    if (gb->bus[0].read != memory)
+	bus_map_read(gb, 0, MBC_ROM_PAGES, memory);
+    memory = cart_bank(gb->cart, high);
+    if (gb->bus[MBC_ROM_PAGES].read != memory)
+	bus_map_read(gb, MBC_ROM_PAGES, MBC_ROM_PAGES, memory);
+}
+
+
+static uint8_t ram_disabled_read(gb_t *gb, uint16_t address)
+{
+    (void)gb;
+    (void)address;
+    return 0xFF;
+}
+
+
+static void ram_disabled_write(gb_t *gb, uint16_t address, uint8_t value)
+{
+    (void)gb;
+    (void)address;
+    (void)value;
+}
+
+
+static uint64_t rtc_ticks_per_second(const mbc_t *mbc)
+{
+    return mbc->rtc_realtime ? RTC_NS_PER_SECOND : RTC_CYCLES_PER_SECOND;
+}
+
+
+/* What the clock's time source reads now */
+static uint64_t rtc_source(const gb_t *gb)
+{
+    struct timespec ts;
+
+    if (!gb->mbc.rtc_realtime)
+	return gb->cycles;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * RTC_NS_PER_SECOND + ts.tv_nsec;
+}
+
+
+/* Bring the clock up to date */
+static void rtc_sync(gb_t *gb)
+{
+    mbc_t *mbc = &gb->mbc;
+    uint64_t now = rtc_source(gb);
+    uint64_t wrap = (uint64_t)RTC_DAYS * RTC_SECONDS_PER_DAY * rtc_ticks_per_second(mbc);
+
+    /* the host's clock may have been set back */
+    if (!mbc->rtc_halted && now > mbc->rtc_since)
+	mbc->rtc_ticks += now - mbc->rtc_since;
+    mbc->rtc_since = now;
+    if (mbc->rtc_ticks >= wrap)
+    {
+	mbc->rtc_ticks %= wrap;
+	mbc->rtc_carry = true;
+    }
+}
+
+
+/* The clock registers as of the last rtc_sync() */
+static void rtc_registers(const mbc_t *mbc, uint8_t *regs)
+{
+    uint64_t seconds = mbc->rtc_ticks / rtc_ticks_per_second(mbc);
+    unsigned days = seconds / RTC_SECONDS_PER_DAY;
+
+    regs[RTC_S] = seconds % 60;
+    regs[RTC_M] = seconds / 60 % 60;
+    regs[RTC_H] = seconds / 3600 % 24;
+    regs[RTC_DL] = days & 0xFF;
+    regs[RTC_DH] = (days >> 8 & RTC_DH_DAY) | (mbc->rtc_halted ? RTC_DH_HALT : 0) |
+		   (mbc->rtc_carry ? RTC_DH_CARRY : 0);
+}
+
+
+/* The latched clock register selected in place of RAM */
+static uint8_t rtc_read(gb_t *gb, uint16_t address)
+{
+    (void)address;
+    return gb->mbc.rtc_latched[gb->mbc.ram_bank - MBC3_RTC_FIRST];
+}
+
+
+/* Set a clock register, the latched copy stays as it was */
+static void rtc_write(gb_t *gb, uint16_t address, uint8_t value)
+{
+    mbc_t *mbc = &gb->mbc;
+    unsigned reg = mbc->ram_bank - MBC3_RTC_FIRST;
+    uint64_t per_second = rtc_ticks_per_second(mbc);
+    uint64_t fraction, seconds;
+    uint8_t regs[MBC3_RTC_COUNT];
+
+    (void)address;
+    rtc_sync(gb);
+    rtc_registers(mbc, regs);
+    fraction = reg == RTC_S ? 0 : mbc->rtc_ticks % per_second;
+    regs[reg] = value & rtc_masks[reg];
+    mbc->rtc_halted = regs[RTC_DH] & RTC_DH_HALT;
+    mbc->rtc_carry = regs[RTC_DH] & RTC_DH_CARRY;
+
+    seconds = (uint64_t)((regs[RTC_DH] & RTC_DH_DAY) << 8 | regs[RTC_DL]) * RTC_SECONDS_PER_DAY +
+	      regs[RTC_H] * 3600 + regs[RTC_M] * 60 + regs[RTC_S];
+    mbc->rtc_ticks = seconds * per_second + fraction;
+}
+
+
+/* Send 0xA000-0xBFFF to handlers, unless they already have them */
+static void map_ram_handlers(gb_t *gb, bus_read_handler_t read, bus_write_handler_t write)
+{
+    const bus_page_t *page = &gb->bus[MBC_RAM_PAGE];
+
+    if (!page->read && page->read_handler == read && page->write_handler == write)
+	return;
+    bus_map_handlers(gb, MBC_RAM_PAGE, MBC_RAM_PAGES, read, write);
+}
+
+
+/* Cartridge RAM, or what is selected in its place, at 0xA000-0xBFFF. RAM
+ * smaller than a bank repeats across it. */
+static void map_ram(gb_t *gb)
+{
+    const mbc_t *mbc = &gb->mbc;
+    size_t size = gb->cart_ram_size;
+    size_t bank = mbc->ram_bank;
+    unsigned count = MBC_RAM_PAGES;
+    uint8_t *memory;
+
+    if (mbc->kind == MBC_NONE && size == 0)
+	return;
+    if (!mbc->ram_enabled)
+    {
+	map_ram_handlers(gb, ram_disabled_read, ram_disabled_write);
+	return;
+    }
+    if (mbc->kind == MBC_3 && bank >= MBC3_RTC_FIRST)
+    {
+	if (bank < MBC3_RTC_FIRST + MBC3_RTC_COUNT)
+	    map_ram_handlers(gb, rtc_read, rtc_write);
+	else
+	    map_ram_handlers(gb, ram_disabled_read, ram_disabled_write);
+	return;
+    }
+    if (size == 0)
+    {
+	map_ram_handlers(gb, ram_disabled_read, ram_disabled_write);
+	return;
+    }
+
+    if (mbc->kind == MBC_1 && !mbc->mode)
+	bank = 0;
+    memory = gb->cart_ram + bank * MBC_RAM_BANK_SIZE % size;
+    if (gb->bus[MBC_RAM_PAGE].read == memory && gb->bus[MBC_RAM_PAGE].write == memory)
+	return;
+    if (size < MBC_RAM_BANK_SIZE)
+	count = size >> GB_PAGE_SHIFT;
+    for (unsigned page = 0; page < MBC_RAM_PAGES; page += count)
+    {
+	bus_map_memory(gb, MBC_RAM_PAGE + page, count, memory, true);
+    }
+}
+
+
+/* Games disable RAM once done writing it, which is when to have the save
+ * file synced, if there is one and the RAM was written since the last
+ * time. Cartridge RAM pages are their own homes. */
+static void ram_done(gb_t *gb)
+{
+    for (unsigned page = MBC_RAM_PAGE; page < MBC_RAM_PAGE + MBC_RAM_PAGES; page++)
+    {
+	if (gb->page_epoch[page] >= gb->save_epoch)
+	{
+	    save_sync(gb->save);
+	    gb->save_epoch = gb_epoch_start(gb);
+	    return;
+	}
+    }
+}
+
+
+/* 0x0000-0x1FFF enables RAM with 0x0A in the low nibble, on all three */
+static void ram_enable_write(gb_t *gb, uint8_t value)
+{
+    bool enabled = (value & 0x0F) == 0x0A;
+
+    if (gb->save && gb->mbc.ram_enabled && !enabled)
+	ram_done(gb);
+    gb->mbc.ram_enabled = enabled;
+    map_ram(gb);
+}
+
+
+static void none_write(gb_t *gb, uint16_t address, uint8_t value)
+{
+    (void)gb;
+    (void)address;
+    (void)value;
+}
+
+
+static void mbc1_write(gb_t *gb, uint16_t address, uint8_t value)
+{
+    mbc_t *mbc = &gb->mbc;
+
+    switch(address >> 13)
+    {
+	case 0:   ram_enable_write(gb, value); break;
+	case 1:
+	{
+	    mbc->rom_bank = value & 0x1F;
+	    map_rom(gb);
+	} break;
+	case 2:
+	{
+	    mbc->ram_bank = value & 0x03;
+	    map_rom(gb);
+	    map_ram(gb);
+	} break;
+	case 3:
+	{
+	    mbc->mode = value & 0x01;
+	    map_rom(gb);
+	    map_ram(gb);
+	} break;
+    }
+}
+
+
+static void mbc3_write(gb_t *gb, uint16_t address, uint8_t value)
+{
+    mbc_t *mbc = &gb->mbc;
+
+    switch(address >> 13)
+    {
+	case 0:   ram_enable_write(gb, value); break;
+	case 1:
+	{
+	    mbc->rom_bank = value & 0x7F;
+	    map_rom(gb);
+	} break;
+	case 2:
+	{
+	    mbc->ram_bank = value & 0x0F;
+	    map_ram(gb);
+	} break;
+	case 3:
+	{
+	    /* writing 0 then 1 latches the clock, the only time it is read */
+	    if (mbc->latch == 0x00 && value == 0x01)
+	    {
+		rtc_sync(gb);
+		rtc_registers(mbc, mbc->rtc_latched);
+	    }
+	    mbc->latch = value;
+	} break;
+    }
+}
+
+
+static void mbc5_write(gb_t *gb, uint16_t address, uint8_t value)
+{
+    mbc_t *mbc = &gb->mbc;
+
+    switch(address >> 12)
+    {
+	case 0:
+	case 1:   ram_enable_write(gb, value); break;
+	case 2:
+	{
+	    mbc->rom_bank = (mbc->rom_bank & 0x100) | value;
+	    map_rom(gb);
+	} break;
+	case 3:
+	{
+	    mbc->rom_bank = (mbc->rom_bank & 0xFF) | (value & 0x01) << 8;
+	    map_rom(gb);
+	} break;
+	case 4:
+	case 5:
+	{
+	    mbc->ram_bank = value & 0x0F;
+	    map_ram(gb);
+	} break;
+    }
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/* Power on the mapper of the cartridge just inserted into `gb` */
+void mbc_reset(gb_t *gb)
+{
+    static const bus_write_handler_t writes[] = {
+	[MBC_NONE] = none_write,
+	[MBC_1] = mbc1_write,
+	[MBC_3] = mbc3_write,
+	[MBC_5] = mbc5_write,
+    };
+    mbc_t *mbc = &gb->mbc;
+    bool realtime = mbc->rtc_realtime;
+
+    memset(mbc, 0, sizeof(*mbc));
+    mbc->kind = mbc_kind(cart_type(gb->cart));
+    mbc->rtc_realtime = realtime;
+    mbc->rtc_since = rtc_source(gb);
+    mbc->rom_bank = 1;
+    mbc->ram_enabled = mbc->kind == MBC_NONE;
+    bus_map_handlers(gb, 0, 2 * MBC_ROM_PAGES, NULL, writes[mbc->kind]);
+    mbc_map(gb);
+}
+
+
+/* Map the banks gb->mbc selects, e.g. once it has been set by loading a
+ * state. Pages already mapped right are left alone. */
+void mbc_map(gb_t *gb)
+{
+    map_rom(gb);
+    map_ram(gb);
+}
+
+
+/*
+ * Run the MBC3 clock off the host's clock instead of the cycle counter,
+ * or back, keeping the time it shows. In real time it keeps going while
+ * the emulator is paused or running fast, and across saved states.
+ */
+void mbc_set_rtc_realtime(gb_t *gb, bool realtime)
+{
+    mbc_t *mbc = &gb->mbc;
+    uint64_t per_second = rtc_ticks_per_second(mbc);
+    uint64_t seconds, fraction;
+
+    if (mbc->rtc_realtime == realtime)
+	return;
+    rtc_sync(gb);
+    seconds = mbc->rtc_ticks / per_second;
+    fraction = mbc->rtc_ticks % per_second;
+    mbc->rtc_realtime = realtime;
+    per_second = rtc_ticks_per_second(mbc);
+    mbc->rtc_ticks = seconds * per_second +
+		     fraction * per_second / (realtime ? RTC_CYCLES_PER_SECOND : RTC_NS_PER_SECOND);
+    mbc->rtc_since = rtc_source(gb);
+}
@@ -0,0 +1,61 @@
+#ifndef __MBC_H__
+#define __MBC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+/*
+ * Memory bank controllers of the inserted cartridge (see cart.h): MBC1,
+ * MBC3 and MBC5. Their registers are only ever reached through the write
+ * handler of the ROM pages, 0x0000-0x7FFF, which repoints pages of the bus
+ * when a bank changes. Reads from ROM and cartridge RAM stay a lookup and a
+ * dereference, and never go near the mapper.
+ *
+ * Cartridge RAM at 0xA000-0xBFFF is the instance's gb->cart_ram, read and
+ * written in place while enabled. States keep it along with the mapper's
+ * registers, as pages after RAM[]'s (see gb.h); putting one back writes
+ * through to the save file if there is one. Without a mapper it is always
+ * enabled, and a cartridge with neither leaves 0xA000-0xBFFF as plain
+ * memory.
+ *
+ * The MBC3 clock costs nothing while the game doesn't look at it: there
+ * is no event ticking it. Its registers are worked out from how far the
+ * cycle counter, or the host's clock in real time, has got since it was
+ * last set, when the game latches or writes them.
+ */
+typedef enum {
+    MBC_NONE,
+    MBC_1,
+    MBC_3,
+    MBC_5,
+} mbc_kind_e;
+
+/* MBC3 clock registers, selected with the RAM bank register */
+#define MBC3_RTC_FIRST 0x08
+#define MBC3_RTC_COUNT 5   /* seconds, minutes, hours, day low, day high */
+
+/* Registers of the mapper. Lives inside the emulator context. */
+typedef struct {
+    uint8_t kind;        /* mbc_kind_e */
+    bool ram_enabled;
+    uint16_t rom_bank;   /* as written, MBC1's low 5 bits of the bank */
+    uint8_t ram_bank;    /* MBC1's upper 2 bits, or an MBC3 clock register */
+    uint8_t mode;        /* MBC1 banking mode */
+    uint8_t latch;       /* MBC3: last write to the latch register */
+
+    /* MBC3 clock: it read rtc_ticks when its time source read rtc_since */
+    bool rtc_realtime;   /* ticks are host nanoseconds, not cycles */
+    bool rtc_halted;
+    bool rtc_carry;      /* the day counter overflowed */
+    uint64_t rtc_ticks;
+    uint64_t rtc_since;
+    uint8_t rtc_latched[MBC3_RTC_COUNT];
+} mbc_t;
+
+void mbc_reset(gb_t *gb);
+void mbc_map(gb_t *gb);
+void mbc_set_rtc_realtime(gb_t *gb, bool realtime);
+
+#endif /* __MBC_H__ */
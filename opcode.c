@@ -185,7 +185,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     },
     [0x0D] = /* DEC C */
     {
-	.inst = INST_INC,
+	.inst = INST_DEC,
 	.bytes    = 1,
 	.cycles   = 4,
 	.op_left = 
@@ -399,7 +399,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     },
     [0x1D] = /* DEC E */
     {
-	.inst = INST_INC,
+	.inst = INST_DEC,
 	.bytes    = 1,
 	.cycles   = 4,
 	.op_left = 
@@ -437,9 +437,9 @@ opcode_t opcodes[OPCODE_COUNT] =
 
     [0x20] = /* JR NZ, e8 */
     { 
-	.inst = INST_JR,
+	.inst = INST_JR_NZ,
 	.bytes    = 2,
-	.cycles   = 111,
+	.cycles   = 8,
 	.op_left  =
 	{
 	    .type = OPERAND_TYPE_E8,
@@ -544,7 +544,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     {
 	.inst = INST_JR_Z,
 	.bytes    = 2,
-	.cycles   = 111,
+	.cycles   = 8,
 	.op_left = 
 	{
 	    .type = OPERAND_TYPE_E8,
@@ -613,7 +613,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     },
     [0x2D] = /* DEC L */
     {
-	.inst = INST_INC,
+	.inst = INST_DEC,
 	.bytes    = 1,
 	.cycles   = 4,
 	.op_left = 
@@ -653,7 +653,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     { 
 	.inst = INST_JR_NC,
 	.bytes    = 2,
-	.cycles   = 111,
+	.cycles   = 8,
 	.op_left  =
 	{
 	    .type = OPERAND_TYPE_E8,
@@ -685,7 +685,7 @@ opcode_t opcodes[OPCODE_COUNT] =
 	.op_left  = 
 	{ 
 	    .type = OPERAND_TYPE_REGISTER_16BIT,
-	    .reg = REGISTER_DE,
+	    .reg = REGISTER_HL,
 	    .immediate = false
 	},
 	.op_right =
@@ -758,7 +758,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     {
 	.inst = INST_JR_C,
 	.bytes    = 2,
-	.cycles   = 111,
+	.cycles   = 8,
 	.op_left = 
 	{
 	    .type = OPERAND_TYPE_E8,
@@ -785,7 +785,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     },
     [0x3A] = /* LDD A, [HL] */
     {
-	.inst = INST_LDI,
+	.inst = INST_LDD,
 	.bytes    = 1,
 	.cycles   = 8,
 	.op_left = 
@@ -827,7 +827,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     },
     [0x3D] = /* DEC A */
     {
-	.inst = INST_INC,
+	.inst = INST_DEC,
 	.bytes    = 1,
 	.cycles   = 4,
 	.op_left = 
@@ -1087,7 +1087,13 @@ opcode_t opcodes[OPCODE_COUNT] =
 	.op_left  = 
 	{
 	    .type = OPERAND_TYPE_REGISTER_8BIT,
-	    .reg = REGISTER_A,
+	    .reg = REGISTER_C,
+	    .immediate = true,
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg = REGISTER_H,
 	    .immediate = true,
 	},
     },
@@ -1372,7 +1378,13 @@ opcode_t opcodes[OPCODE_COUNT] =
 	.op_left  = 
 	{
 	    .type = OPERAND_TYPE_REGISTER_8BIT,
-	    .reg = REGISTER_A,
+	    .reg = REGISTER_E,
+	    .immediate = true,
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg = REGISTER_H,
 	    .immediate = true,
 	},
     },
@@ -1657,7 +1669,13 @@ opcode_t opcodes[OPCODE_COUNT] =
 	.op_left  = 
 	{
 	    .type = OPERAND_TYPE_REGISTER_8BIT,
-	    .reg = REGISTER_A,
+	    .reg = REGISTER_L,
+	    .immediate = true,
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg = REGISTER_H,
 	    .immediate = true,
 	},
     },
@@ -1841,7 +1859,7 @@ opcode_t opcodes[OPCODE_COUNT] =
 	{ 
 	    .type = OPERAND_TYPE_REGISTER_16BIT,
 	    .reg  = REGISTER_HL,
-	    .immediate = true
+	    .immediate = false
 	},
 	.op_right =
 	{ 
@@ -1933,6 +1951,12 @@ opcode_t opcodes[OPCODE_COUNT] =
 	    .reg = REGISTER_A,
 	    .immediate = true,
 	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg = REGISTER_H,
+	    .immediate = true,
+	},
     },
     [0x7D] = /* LD A, L */
     {
@@ -3199,7 +3223,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     {
 	.inst = INST_RET_NZ,
 	.bytes    = 1,
-	.cycles   = 111,
+	.cycles   = 8,
     },
 
     [0xC1] = /* POP BC */
@@ -3219,7 +3243,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     {
 	.inst = INST_JP_NZ,
 	.bytes    = 3,
-	.cycles   = 111,
+	.cycles   = 12,
 	.op_left = 
 	{
 	    .type = OPERAND_TYPE_A16,
@@ -3231,7 +3255,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     {
 	.inst = INST_JP,
 	.bytes    = 3,
-	.cycles   = 111,
+	.cycles   = 16,
 	.op_left = 
 	{
 	    .type = OPERAND_TYPE_A16,
@@ -3243,7 +3267,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     {
 	.inst = INST_CALL_NZ,
 	.bytes    = 3,
-	.cycles   = 111,
+	.cycles   = 12,
 	.op_left = 
 	{
 	    .type = OPERAND_TYPE_A16,
@@ -3266,14 +3290,20 @@ opcode_t opcodes[OPCODE_COUNT] =
 
     [0xC6] = /* ADD A, n8 */
     {
-	.inst = INST_ADD,
-	.bytes    = 2,
-	.cycles   = 8,
+	.inst   = INST_ADD,
+	.bytes  = 2,
+	.cycles = 8,
 	.op_left = 
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+	.op_right = 
 	{
 	    .type = OPERAND_TYPE_N8,
 	    .immediate = true
-	}
+	},
     },
 
     [0xC7] = /* RST $00 */
@@ -3287,7 +3317,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     {
 	.inst = INST_RET_Z,
 	.bytes    = 1,
-	.cycles   = 16,
+	.cycles   = 8,
     },
 
     [0xC9] = /* RET */
@@ -3301,7 +3331,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     {
 	.inst = INST_JP_Z,
 	.bytes    = 3,
-	.cycles   = 111,
+	.cycles   = 12,
 	.op_left =
 	{
 	    .type = OPERAND_TYPE_A16,
@@ -3309,37 +3339,58 @@ opcode_t opcodes[OPCODE_COUNT] =
 	}
     },
 
-    [0xCB] = /* PREFIX */
+    [0xCB] = /* PREFIX, the next byte indexes cb_opcodes[] */
     {
 	.inst = INST_PREFIX,
-	.bytes    = 1,
+	.bytes    = 2,
 	.cycles   = 4,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_N8,
+	    .immediate = true
+	},
     },
 
-    [0xCC] = /* CALL Z */
+    [0xCC] = /* CALL Z, a16 */
     {
-	.inst = INST_CALL_Z,
-	.bytes    = 3,
-	.cycles   = 111,
+	.inst   = INST_CALL_Z,
+	.bytes  = 3,
+	.cycles = 12,
+	.op_left = 
+	{
+	    .type = OPERAND_TYPE_A16,
+	    .immediate = true
+	},
     },
 
     [0xCD] = /* CALL a16 */
     {
-	.inst = INST_CALL,
-	.bytes    = 3,
-	.cycles   = 24,
+	.inst   = INST_CALL,
+	.bytes  = 3,
+	.cycles = 24,
+	.op_left = 
+	{
+	    .type = OPERAND_TYPE_A16,
+	    .immediate = true
+	},
     },
 
     [0xCE] = /* ADC A, n8 */
     {
-	.inst = INST_ADC,
-	.bytes    = 2,
-	.cycles   = 8,
+	.inst   = INST_ADC,
+	.bytes  = 2,
+	.cycles = 8,
 	.op_left = 
 	{
-	   .type = OPERAND_TYPE_N8,
-	   .immediate = true,
-	}
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+	.op_right = 
+	{
+	    .type = OPERAND_TYPE_N8,
+	    .immediate = true
+	},
     },
 
     [0xCF] = /* RST $08 */
@@ -3354,7 +3405,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     {
 	.inst = INST_RET_NC,
 	.bytes    = 1,
-	.cycles   = 111,
+	.cycles   = 8,
     },
 
     [0xD1] = /* POP DE */
@@ -3373,7 +3424,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     [0xD2] = /* JP NC, a16 */
     {
 	.inst = INST_JP_NC,
-	.bytes    = 1,
+	.bytes    = 3,
 	.cycles   = 12,
 	.op_left = 
 	{
@@ -3388,7 +3439,7 @@ opcode_t opcodes[OPCODE_COUNT] =
     {
 	.inst   = INST_CALL_NC,
 	.bytes  = 3,
-	.cycles = 111,
+	.cycles = 12,
 	.op_left = 
 	{
 	    .type = OPERAND_TYPE_A16,
@@ -3436,15 +3487,9 @@ opcode_t opcodes[OPCODE_COUNT] =
 
     [0xD8] = /* RET C */
     {
-	.inst   = INST_RET,
+	.inst   = INST_RET_C,
 	.bytes  = 1,
-	.cycles = 16,
-	.op_left = 
-	{
-	    .type = OPERAND_TYPE_REGISTER_8BIT,
-	    .reg = REGISTER_C, 
-	    .immediate = true
-	}
+	.cycles = 8,
     },
 
     [0xD9] = /* RETI */
@@ -3457,8 +3502,8 @@ opcode_t opcodes[OPCODE_COUNT] =
     [0xDA] = /* JP C, a16 */
     {
 	.inst   = INST_JP_C,
-	.bytes  = 1,
-	.cycles = 111,
+	.bytes  = 3,
+	.cycles = 12,
 	.op_left = 
 	{
 	    .type = OPERAND_TYPE_A16,
@@ -3468,17 +3513,16 @@ opcode_t opcodes[OPCODE_COUNT] =
 
     [0xDB] = { 0 }, /* INVALID INSTRUCTION */
 
-    [0xDC] = /* CALL C */
+    [0xDC] = /* CALL C, a16 */
     {
-	.inst   = INST_CALL,
+	.inst   = INST_CALL_C,
 	.bytes  = 3,
-	.cycles = 24,
+	.cycles = 12,
 	.op_left = 
 	{
-	    .type = OPERAND_TYPE_REGISTER_8BIT,
-	    .reg  = REGISTER_C,
+	    .type = OPERAND_TYPE_A16,
 	    .immediate = true
-	}
+	},
     },
 
     [0xDD] = { 0 }, /* INVALID INSTRUCTION */
@@ -3506,17 +3550,6 @@ opcode_t opcodes[OPCODE_COUNT] =
 	.inst   = INST_RST,
 	.bytes  = 1,
 	.cycles = 16,
-	.op_left = 
-	{
-	    .type = OPERAND_TYPE_REGISTER_8BIT,
-	    .reg  = REGISTER_A,
-	    .immediate = true
-	},
-	.op_right = 
-	{
-	    .type = OPERAND_TYPE_N8,
-	    .immediate = true
-	}
     },
 
     /* 0xEX */ 
@@ -3798,6 +3831,12 @@ opcode_t opcodes[OPCODE_COUNT] =
 	.bytes  = 2,
 	.cycles = 12,
 	.op_left = 
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = true
+	},
+	.op_right = 
 	{
 	    .type = OPERAND_TYPE_E8,
 	    .immediate = true
@@ -3806,10 +3845,16 @@ opcode_t opcodes[OPCODE_COUNT] =
 
     [0xF9] = /* LD SP, HL */
     {
-	.inst   = INST_JP,
+	.inst   = INST_LD,
 	.bytes  = 1,
 	.cycles = 8,
 	.op_left = 
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_SP,
+	    .immediate = true
+	},
+	.op_right = 
 	{
 	    .type = OPERAND_TYPE_REGISTER_16BIT,
 	    .reg  = REGISTER_HL,
@@ -3859,22 +3904,4517 @@ opcode_t opcodes[OPCODE_COUNT] =
 	},
 	.op_right = 
 	{
-	    .type = OPERAND_TYPE_A8,
+	    .type = OPERAND_TYPE_N8,
 	    .immediate = true
 	},
     },
 
     [0xFF] = /* RST 38 */
     {
-	.inst   = INST_CP,
-	.bytes  = 2,
-	.cycles = 8,
+	.inst   = INST_RST,
+	.bytes  = 1,
+	.cycles = 16,
     },
 };
 
-inline opcode_t *opcode_get(uint8_t opcode_value)
+/*
+ * Second-level table for the instructions prefixed by 0xCB, indexed by
+ * the byte following the prefix. Lengths and cycles are for the whole
+ * instruction, prefix included.
+ */
+opcode_t cb_opcodes[OPCODE_COUNT] =
 {
-    return &opcodes[opcode_value];
+    [0x00] = /* RLC B */
+    {
+	.inst = INST_RLC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x01] = /* RLC C */
+    {
+	.inst = INST_RLC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x02] = /* RLC D */
+    {
+	.inst = INST_RLC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x03] = /* RLC E */
+    {
+	.inst = INST_RLC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x04] = /* RLC H */
+    {
+	.inst = INST_RLC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x05] = /* RLC L */
+    {
+	.inst = INST_RLC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x06] = /* RLC [HL] */
+    {
+	.inst = INST_RLC,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x07] = /* RLC A */
+    {
+	.inst = INST_RLC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x08] = /* RRC B */
+    {
+	.inst = INST_RRC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x09] = /* RRC C */
+    {
+	.inst = INST_RRC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x0A] = /* RRC D */
+    {
+	.inst = INST_RRC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x0B] = /* RRC E */
+    {
+	.inst = INST_RRC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x0C] = /* RRC H */
+    {
+	.inst = INST_RRC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x0D] = /* RRC L */
+    {
+	.inst = INST_RRC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x0E] = /* RRC [HL] */
+    {
+	.inst = INST_RRC,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x0F] = /* RRC A */
+    {
+	.inst = INST_RRC,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x10] = /* RL B */
+    {
+	.inst = INST_RL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x11] = /* RL C */
+    {
+	.inst = INST_RL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x12] = /* RL D */
+    {
+	.inst = INST_RL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x13] = /* RL E */
+    {
+	.inst = INST_RL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x14] = /* RL H */
+    {
+	.inst = INST_RL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x15] = /* RL L */
+    {
+	.inst = INST_RL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x16] = /* RL [HL] */
+    {
+	.inst = INST_RL,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x17] = /* RL A */
+    {
+	.inst = INST_RL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x18] = /* RR B */
+    {
+	.inst = INST_RR,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x19] = /* RR C */
+    {
+	.inst = INST_RR,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x1A] = /* RR D */
+    {
+	.inst = INST_RR,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x1B] = /* RR E */
+    {
+	.inst = INST_RR,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x1C] = /* RR H */
+    {
+	.inst = INST_RR,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x1D] = /* RR L */
+    {
+	.inst = INST_RR,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x1E] = /* RR [HL] */
+    {
+	.inst = INST_RR,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x1F] = /* RR A */
+    {
+	.inst = INST_RR,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x20] = /* SLA B */
+    {
+	.inst = INST_SLA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x21] = /* SLA C */
+    {
+	.inst = INST_SLA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x22] = /* SLA D */
+    {
+	.inst = INST_SLA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x23] = /* SLA E */
+    {
+	.inst = INST_SLA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x24] = /* SLA H */
+    {
+	.inst = INST_SLA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x25] = /* SLA L */
+    {
+	.inst = INST_SLA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x26] = /* SLA [HL] */
+    {
+	.inst = INST_SLA,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x27] = /* SLA A */
+    {
+	.inst = INST_SLA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x28] = /* SRA B */
+    {
+	.inst = INST_SRA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x29] = /* SRA C */
+    {
+	.inst = INST_SRA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x2A] = /* SRA D */
+    {
+	.inst = INST_SRA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x2B] = /* SRA E */
+    {
+	.inst = INST_SRA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x2C] = /* SRA H */
+    {
+	.inst = INST_SRA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x2D] = /* SRA L */
+    {
+	.inst = INST_SRA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x2E] = /* SRA [HL] */
+    {
+	.inst = INST_SRA,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x2F] = /* SRA A */
+    {
+	.inst = INST_SRA,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x30] = /* SWAP B */
+    {
+	.inst = INST_SWAP,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x31] = /* SWAP C */
+    {
+	.inst = INST_SWAP,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x32] = /* SWAP D */
+    {
+	.inst = INST_SWAP,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x33] = /* SWAP E */
+    {
+	.inst = INST_SWAP,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x34] = /* SWAP H */
+    {
+	.inst = INST_SWAP,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x35] = /* SWAP L */
+    {
+	.inst = INST_SWAP,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x36] = /* SWAP [HL] */
+    {
+	.inst = INST_SWAP,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x37] = /* SWAP A */
+    {
+	.inst = INST_SWAP,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x38] = /* SRL B */
+    {
+	.inst = INST_SRL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x39] = /* SRL C */
+    {
+	.inst = INST_SRL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x3A] = /* SRL D */
+    {
+	.inst = INST_SRL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x3B] = /* SRL E */
+    {
+	.inst = INST_SRL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x3C] = /* SRL H */
+    {
+	.inst = INST_SRL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x3D] = /* SRL L */
+    {
+	.inst = INST_SRL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x3E] = /* SRL [HL] */
+    {
+	.inst = INST_SRL,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x3F] = /* SRL A */
+    {
+	.inst = INST_SRL,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x40] = /* BIT 0, B */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x41] = /* BIT 0, C */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x42] = /* BIT 0, D */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x43] = /* BIT 0, E */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x44] = /* BIT 0, H */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x45] = /* BIT 0, L */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x46] = /* BIT 0, [HL] */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 12,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x47] = /* BIT 0, A */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x48] = /* BIT 1, B */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x49] = /* BIT 1, C */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x4A] = /* BIT 1, D */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x4B] = /* BIT 1, E */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x4C] = /* BIT 1, H */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x4D] = /* BIT 1, L */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x4E] = /* BIT 1, [HL] */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 12,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x4F] = /* BIT 1, A */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x50] = /* BIT 2, B */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x51] = /* BIT 2, C */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x52] = /* BIT 2, D */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x53] = /* BIT 2, E */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x54] = /* BIT 2, H */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x55] = /* BIT 2, L */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x56] = /* BIT 2, [HL] */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 12,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x57] = /* BIT 2, A */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x58] = /* BIT 3, B */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x59] = /* BIT 3, C */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x5A] = /* BIT 3, D */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x5B] = /* BIT 3, E */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x5C] = /* BIT 3, H */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x5D] = /* BIT 3, L */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x5E] = /* BIT 3, [HL] */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 12,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x5F] = /* BIT 3, A */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x60] = /* BIT 4, B */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x61] = /* BIT 4, C */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x62] = /* BIT 4, D */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x63] = /* BIT 4, E */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x64] = /* BIT 4, H */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x65] = /* BIT 4, L */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x66] = /* BIT 4, [HL] */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 12,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x67] = /* BIT 4, A */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x68] = /* BIT 5, B */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x69] = /* BIT 5, C */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x6A] = /* BIT 5, D */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x6B] = /* BIT 5, E */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x6C] = /* BIT 5, H */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x6D] = /* BIT 5, L */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x6E] = /* BIT 5, [HL] */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 12,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x6F] = /* BIT 5, A */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x70] = /* BIT 6, B */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x71] = /* BIT 6, C */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x72] = /* BIT 6, D */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x73] = /* BIT 6, E */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x74] = /* BIT 6, H */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x75] = /* BIT 6, L */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x76] = /* BIT 6, [HL] */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 12,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x77] = /* BIT 6, A */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x78] = /* BIT 7, B */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x79] = /* BIT 7, C */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x7A] = /* BIT 7, D */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x7B] = /* BIT 7, E */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x7C] = /* BIT 7, H */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x7D] = /* BIT 7, L */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x7E] = /* BIT 7, [HL] */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 12,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x7F] = /* BIT 7, A */
+    {
+	.inst = INST_BIT,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x80] = /* RES 0, B */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x81] = /* RES 0, C */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x82] = /* RES 0, D */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x83] = /* RES 0, E */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x84] = /* RES 0, H */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x85] = /* RES 0, L */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x86] = /* RES 0, [HL] */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x87] = /* RES 0, A */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x88] = /* RES 1, B */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x89] = /* RES 1, C */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x8A] = /* RES 1, D */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x8B] = /* RES 1, E */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x8C] = /* RES 1, H */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x8D] = /* RES 1, L */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x8E] = /* RES 1, [HL] */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x8F] = /* RES 1, A */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x90] = /* RES 2, B */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x91] = /* RES 2, C */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x92] = /* RES 2, D */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x93] = /* RES 2, E */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x94] = /* RES 2, H */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x95] = /* RES 2, L */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x96] = /* RES 2, [HL] */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x97] = /* RES 2, A */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0x98] = /* RES 3, B */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0x99] = /* RES 3, C */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0x9A] = /* RES 3, D */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0x9B] = /* RES 3, E */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0x9C] = /* RES 3, H */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0x9D] = /* RES 3, L */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0x9E] = /* RES 3, [HL] */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0x9F] = /* RES 3, A */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0xA0] = /* RES 4, B */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0xA1] = /* RES 4, C */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0xA2] = /* RES 4, D */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0xA3] = /* RES 4, E */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0xA4] = /* RES 4, H */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0xA5] = /* RES 4, L */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0xA6] = /* RES 4, [HL] */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0xA7] = /* RES 4, A */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0xA8] = /* RES 5, B */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0xA9] = /* RES 5, C */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0xAA] = /* RES 5, D */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0xAB] = /* RES 5, E */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0xAC] = /* RES 5, H */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0xAD] = /* RES 5, L */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0xAE] = /* RES 5, [HL] */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0xAF] = /* RES 5, A */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0xB0] = /* RES 6, B */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0xB1] = /* RES 6, C */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0xB2] = /* RES 6, D */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0xB3] = /* RES 6, E */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0xB4] = /* RES 6, H */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0xB5] = /* RES 6, L */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0xB6] = /* RES 6, [HL] */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0xB7] = /* RES 6, A */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0xB8] = /* RES 7, B */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0xB9] = /* RES 7, C */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0xBA] = /* RES 7, D */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0xBB] = /* RES 7, E */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0xBC] = /* RES 7, H */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0xBD] = /* RES 7, L */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0xBE] = /* RES 7, [HL] */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0xBF] = /* RES 7, A */
+    {
+	.inst = INST_RES,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0xC0] = /* SET 0, B */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0xC1] = /* SET 0, C */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0xC2] = /* SET 0, D */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0xC3] = /* SET 0, E */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0xC4] = /* SET 0, H */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0xC5] = /* SET 0, L */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0xC6] = /* SET 0, [HL] */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0xC7] = /* SET 0, A */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 0,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0xC8] = /* SET 1, B */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0xC9] = /* SET 1, C */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0xCA] = /* SET 1, D */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0xCB] = /* SET 1, E */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0xCC] = /* SET 1, H */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0xCD] = /* SET 1, L */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0xCE] = /* SET 1, [HL] */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0xCF] = /* SET 1, A */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 1,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0xD0] = /* SET 2, B */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0xD1] = /* SET 2, C */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0xD2] = /* SET 2, D */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0xD3] = /* SET 2, E */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0xD4] = /* SET 2, H */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0xD5] = /* SET 2, L */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0xD6] = /* SET 2, [HL] */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0xD7] = /* SET 2, A */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 2,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0xD8] = /* SET 3, B */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0xD9] = /* SET 3, C */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0xDA] = /* SET 3, D */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0xDB] = /* SET 3, E */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0xDC] = /* SET 3, H */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0xDD] = /* SET 3, L */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0xDE] = /* SET 3, [HL] */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0xDF] = /* SET 3, A */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 3,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0xE0] = /* SET 4, B */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0xE1] = /* SET 4, C */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0xE2] = /* SET 4, D */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0xE3] = /* SET 4, E */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0xE4] = /* SET 4, H */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0xE5] = /* SET 4, L */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0xE6] = /* SET 4, [HL] */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0xE7] = /* SET 4, A */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 4,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0xE8] = /* SET 5, B */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0xE9] = /* SET 5, C */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0xEA] = /* SET 5, D */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0xEB] = /* SET 5, E */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0xEC] = /* SET 5, H */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0xED] = /* SET 5, L */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0xEE] = /* SET 5, [HL] */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0xEF] = /* SET 5, A */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 5,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0xF0] = /* SET 6, B */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0xF1] = /* SET 6, C */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0xF2] = /* SET 6, D */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0xF3] = /* SET 6, E */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0xF4] = /* SET 6, H */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0xF5] = /* SET 6, L */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0xF6] = /* SET 6, [HL] */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0xF7] = /* SET 6, A */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 6,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+
+    [0xF8] = /* SET 7, B */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_B,
+	    .immediate = true
+	},
+    },
+
+    [0xF9] = /* SET 7, C */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_C,
+	    .immediate = true
+	},
+    },
+
+    [0xFA] = /* SET 7, D */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_D,
+	    .immediate = true
+	},
+    },
+
+    [0xFB] = /* SET 7, E */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_E,
+	    .immediate = true
+	},
+    },
+
+    [0xFC] = /* SET 7, H */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_H,
+	    .immediate = true
+	},
+    },
+
+    [0xFD] = /* SET 7, L */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_L,
+	    .immediate = true
+	},
+    },
+
+    [0xFE] = /* SET 7, [HL] */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 16,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_16BIT,
+	    .reg  = REGISTER_HL,
+	    .immediate = false
+	},
+    },
+
+    [0xFF] = /* SET 7, A */
+    {
+	.inst = INST_SET,
+	.bytes    = 2,
+	.cycles   = 8,
+	.op_left  =
+	{
+	    .type = OPERAND_TYPE_U3,
+	    .value = 7,
+	    .immediate = true
+	},
+	.op_right =
+	{
+	    .type = OPERAND_TYPE_REGISTER_8BIT,
+	    .reg  = REGISTER_A,
+	    .immediate = true
+	},
+    },
+};
+
+inline opcode_t *opcode_get(uint8_t opcode_value)
+{
+    return &opcodes[opcode_value];
+}
+
+
+/* Instruction encoded by 0xCB followed by `opcode_value` */
+inline opcode_t *opcode_cb_get(uint8_t opcode_value)
+{
+    return &cb_opcodes[opcode_value];
 }
 
 
@@ -19,6 +19,7 @@ typedef struct {
 } opcode_t;
 
 opcode_t *opcode_get(uint8_t opcode_value);
+opcode_t *opcode_cb_get(uint8_t opcode_value);
 void opcode_print(uint8_t opcode_value);
 
 
@@ -2,6 +2,7 @@
 #define __OPERAND_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "register.h"
 
@@ -14,12 +15,14 @@ typedef enum {
     OPERAND_TYPE_A8,             /* unsigned 8-bit value as offset from $FF00 */
     OPERAND_TYPE_A16,            /* 16-bit address (little-endian) */
     OPERAND_TYPE_E8,             /* 8-bit signed data */
+    OPERAND_TYPE_U3,             /* bit index 0-7 encoded in the opcode */
 } operand_type_e;
 
 typedef struct {
     operand_type_e type;
     register_e reg;
     bool immediate;
+    uint8_t value;               /* bit index of OPERAND_TYPE_U3 */
 } operand_t;
 
 #endif /* __OPERAND_H__ */
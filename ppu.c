@@ -0,0 +1,267 @@
+#include <string.h>
+
+#include "ppu.h"
+
+/*
+ * A decoded row of a tile is 8 bytes, the leftmost pixel first, and is
+ * handled as a uint64_t on the way: expand[] spreads the 8 bits of a plane
+ * to the low bit of 8 bytes, so a row is expand[low] | expand[high] << 1.
+ * The byte order is the host's, little-endian.
+ *
+ * Known simplifications: mode 3 doesn't get longer with sprites or the
+ * window, the window starts on any line from WY on rather than only once
+ * LY has matched WY, and what the game writes to VRAM or OAM while it is
+ * being drawn from shows up at once.
+ */
+
+/* LCDC bits */
+#define LCDC_BG_ENABLE     0x01  /* the window too, on the DMG */
+#define LCDC_OBJ_ENABLE    0x02
+#define LCDC_OBJ_TALL      0x04  /* 8x16 sprites */
+#define LCDC_BG_MAP        0x08
+#define LCDC_TILES_UNSIGNED 0x10 /* tiles 0-255 from 0x8000, else -128-127 from 0x9000 */
+#define LCDC_WINDOW_ENABLE 0x20
+#define LCDC_WINDOW_MAP    0x40
+
+/* sprite attributes */
+#define OBJ_BEHIND_BG      0x80
+#define OBJ_FLIP_Y         0x40
+#define OBJ_FLIP_X         0x20
+#define OBJ_PALETTE_1      0x10
+
+#define MAP_LOW            0x9800
+#define MAP_HIGH           0x9C00
+#define OAM                0xFE00
+#define OAM_SPRITES        40
+#define SPRITES_PER_LINE   10
+
+#define IO_SCY             0xFF42
+#define IO_SCX             0xFF43
+#define IO_BGP             0xFF47
+#define IO_OBP0            0xFF48
+#define IO_OBP1            0xFF49
+#define IO_WY              0xFF4A
+#define IO_WX              0xFF4B
+
+#define EXPAND_BIT(b, i)   ((uint64_t)((b) >> (7 - (i)) & 1) << ((i) * 8))
+#define EXPAND_1(b)        (EXPAND_BIT(b, 0) | EXPAND_BIT(b, 1) | EXPAND_BIT(b, 2) | \
+			    EXPAND_BIT(b, 3) | EXPAND_BIT(b, 4) | EXPAND_BIT(b, 5) | \
+			    EXPAND_BIT(b, 6) | EXPAND_BIT(b, 7))
+#define EXPAND_4(b)        EXPAND_1(b), EXPAND_1((b) + 1), EXPAND_1((b) + 2), EXPAND_1((b) + 3)
+#define EXPAND_16(b)       EXPAND_4(b), EXPAND_4((b) + 4), EXPAND_4((b) + 8), EXPAND_4((b) + 12)
+#define EXPAND_64(b)       EXPAND_16(b), EXPAND_16((b) + 16), EXPAND_16((b) + 32), \
+			   EXPAND_16((b) + 48)
+
+static const uint64_t expand[256] = {
+    EXPAND_64(0), EXPAND_64(64), EXPAND_64(128), EXPAND_64(192)
+};
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+
+/* Decode the tiles written since the last line was drawn */
+static void tiles_decode(ppu_t *ppu, const uint8_t *memory)
+{
+    for (size_t i = 0; i < PPU_TILES / 64; i++)
+    {
+	for (; ppu->stale[i]; ppu->stale[i] &= ppu->stale[i] - 1)
+	{
+	    size_t tile = i * 64 + __builtin_ctzll(ppu->stale[i]);
+	    const uint8_t *planes = &memory[PPU_TILE_DATA + tile * 16];
+
+	    for (int row = 0; row < 8; row++)
+	    {
+		uint64_t pixels = expand[planes[row * 2]] | expand[planes[row * 2 + 1]] << 1;
+
+		memcpy(ppu->tiles[tile][row], &pixels, 8);
+	    }
+	}
+    }
+}
+
+
+/* The 4 shades of a palette register, by color number */
+static void palette_shades(uint8_t palette, uint8_t *shades)
+{
+    for (int color = 0; color < 4; color++)
+    {
+	shades[color] = palette >> (color * 2) & 3;
+    }
+}
+
+
+/*
+ * Color numbers of row `row` of `count` tiles of the tile map row at
+ * `map`, from column `column` on and wrapping around its right edge, to
+ * `out`.
+ */
+static void map_row(const ppu_t *ppu, const uint8_t *map, unsigned column, unsigned row,
+		    unsigned count, uint8_t lcdc, uint8_t *out)
+{
+    /* numbers 0-127 are the tiles from 0x9000 in signed addressing */
+    unsigned low_base = lcdc & LCDC_TILES_UNSIGNED ? 0 : 0x100;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+	uint8_t number = map[(column + i) & 31];
+	unsigned tile = number < 0x80 ? low_base + number : number;
+
+	memcpy(&out[i * 8], ppu->tiles[tile][row], 8);
+    }
+}
+
+
+/*
+ * Draw the sprites on line `ly` over `line`, whose background and window
+ * color numbers are `bg`. The first 10 sprites on the line in OAM are
+ * drawn, and where they overlap, the one with the smaller X, or the
+ * earlier in OAM for the same X, shows.
+ */
+static void sprites_render(const ppu_t *ppu, const uint8_t *memory, uint8_t lcdc, uint8_t ly,
+			   const uint8_t *bg, uint8_t *line)
+{
+    const uint8_t *found[SPRITES_PER_LINE];
+    unsigned height = lcdc & LCDC_OBJ_TALL ? 16 : 8;
+    unsigned count = 0;
+    bool taken[PPU_WIDTH] = { false };
+
+    for (unsigned i = 0; i < OAM_SPRITES && count < SPRITES_PER_LINE; i++)
+    {
+	const uint8_t *sprite = &memory[OAM + i * 4];
+	unsigned j;
+
+	if ((unsigned)(ly + 16 - sprite[0]) >= height)
+	    continue;
+	/* in order of priority, stable so ties stay in OAM order */
+	for (j = count++; j > 0 && found[j - 1][1] > sprite[1]; j--)
+	{
+	    found[j] = found[j - 1];
+	}
+	found[j] = sprite;
+    }
+
+    for (unsigned i = 0; i < count; i++)
+    {
+	const uint8_t *sprite = found[i];
+	uint8_t attributes = sprite[3];
+	unsigned row = ly + 16 - sprite[0];
+	unsigned tile = sprite[2];
+	uint8_t shades[4];
+	uint64_t pixels;
+
+	if (attributes & OBJ_FLIP_Y)
+	    row = height - 1 - row;
+	if (height == 16)
+	    tile = (tile & 0xFE) | row >> 3;
+	memcpy(&pixels, ppu->tiles[tile][row & 7], 8);
+	if (attributes & OBJ_FLIP_X)
+	    pixels = __builtin_bswap64(pixels);
+	palette_shades(memory[attributes & OBJ_PALETTE_1 ? IO_OBP1 : IO_OBP0], shades);
+
+	for (int x = sprite[1] - 8; pixels; x++, pixels >>= 8)
+	{
+	    uint8_t color = pixels & 3;
+
+	    /* color 0 is transparent, and lets the sprites behind show */
+	    if (x < 0 || x >= PPU_WIDTH || !color || taken[x])
+		continue;
+	    taken[x] = true;
+	    if (!(attributes & OBJ_BEHIND_BG) || !bg[x])
+		line[x] = shades[color];
+	}
+    }
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/* A white screen, and every tile to be decoded before it is drawn from */
+void ppu_reset(ppu_t *ppu)
+{
+    ppu_blank(ppu);
+    ppu_tiles_stale(ppu, PPU_TILE_DATA, PPU_TILE_DATA_END);
+}
+
+
+/* Turn the screen white, as when the LCD is switched off */
+void ppu_blank(ppu_t *ppu)
+{
+    memset(ppu->framebuffer, 0, sizeof(ppu->framebuffer));
+}
+
+
+/* Mark the tiles with bytes in [start, end) to be decoded again, for
+ * VRAM written other than by the bus */
+void ppu_tiles_stale(ppu_t *ppu, uint32_t start, uint32_t end)
+{
+    if (start < PPU_TILE_DATA)
+	start = PPU_TILE_DATA;
+    if (end > PPU_TILE_DATA_END)
+	end = PPU_TILE_DATA_END;
+    for (uint32_t address = start; address < end; address = (address | 15) + 1)
+    {
+	ppu_tile_written(ppu, address);
+    }
+}
+
+
+/*
+ * Draw line `ly` of the screen from `memory`, the guest address space,
+ * with `lcdc` as LCDC. `window_line` is the line of the window to draw
+ * next, counted up when the window is on this line.
+ */
+void ppu_render_line(ppu_t *ppu, const uint8_t *memory, uint8_t lcdc, uint8_t ly,
+		     uint8_t *window_line)
+{
+    /* room for the tile the line starts in part of and the one it ends in */
+    uint8_t colors[PPU_WIDTH + 16];
+    uint8_t *line;
+    uint8_t *bg = colors;
+
+    if (ly >= PPU_HEIGHT)
+	return;
+    line = ppu->framebuffer[ly];
+    tiles_decode(ppu, memory);
+
+    if (lcdc & LCDC_BG_ENABLE)
+    {
+	uint8_t y = memory[IO_SCY] + ly;
+	uint8_t scx = memory[IO_SCX];
+	uint8_t wx = memory[IO_WX];
+	uint8_t shades[4];
+
+	map_row(ppu, &memory[(lcdc & LCDC_BG_MAP ? MAP_HIGH : MAP_LOW) + y / 8 * 32],
+		scx / 8, y & 7, PPU_WIDTH / 8 + 1, lcdc, colors);
+	bg = &colors[scx & 7];
+
+	if ((lcdc & LCDC_WINDOW_ENABLE) && ly >= memory[IO_WY] && wx < PPU_WIDTH + 7)
+	{
+	    uint8_t window[PPU_WIDTH + 8];
+	    int start = wx - 7;
+
+	    map_row(ppu, &memory[(lcdc & LCDC_WINDOW_MAP ? MAP_HIGH : MAP_LOW) +
+				 *window_line / 8 * 32],
+		    0, *window_line & 7, PPU_WIDTH / 8 + 1, lcdc, window);
+	    if (start < 0)
+		memcpy(bg, &window[-start], PPU_WIDTH);
+	    else
+		memcpy(&bg[start], window, PPU_WIDTH - start);
+	    (*window_line)++;
+	}
+
+	palette_shades(memory[IO_BGP], shades);
+	for (int x = 0; x < PPU_WIDTH; x++)
+	{
+	    line[x] = shades[bg[x]];
+	}
+    }
+    else
+    {
+	/* the DMG draws white, which sprites still show over */
+	memset(colors, 0, PPU_WIDTH);
+	memset(line, 0, PPU_WIDTH);
+    }
+
+    if (lcdc & LCDC_OBJ_ENABLE)
+	sprites_render(ppu, memory, lcdc, ly, bg, line);
+}
@@ -0,0 +1,51 @@
+#ifndef __PPU_H__
+#define __PPU_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * DMG picture processing: the LCD is drawn a scanline at a time, as each
+ * line enters mode 3, from VRAM, OAM and the LCD registers as they are at
+ * that moment, so mid-frame register changes land on the right line.
+ *
+ * The 384 tiles of VRAM are kept decoded from their 2bpp planes to a
+ * byte per pixel. A write to the tile data at 0x8000-0x97FF marks its
+ * tile stale, and stale tiles are decoded again before the next line is
+ * drawn, so drawing is copying rows of decoded tiles and looking colors
+ * up in the palettes.
+ *
+ * Neither is part of saved states: the tiles are worked out from VRAM
+ * again, and the screen is drawn anew by the next frame.
+ */
+#define PPU_WIDTH         160
+#define PPU_HEIGHT        144
+#define PPU_TILES         384
+#define PPU_TILE_DATA     0x8000
+#define PPU_TILE_DATA_END 0x9800
+
+typedef struct {
+    /* shades, 0 is white and 3 black */
+    uint8_t framebuffer[PPU_HEIGHT][PPU_WIDTH];
+    /* color numbers, by tile, row and pixel from the left */
+    uint8_t tiles[PPU_TILES][8][8];
+    uint64_t stale[PPU_TILES / 64];
+} ppu_t;
+
+void ppu_reset(ppu_t *ppu);
+void ppu_blank(ppu_t *ppu);
+void ppu_tiles_stale(ppu_t *ppu, uint32_t start, uint32_t end);
+void ppu_render_line(ppu_t *ppu, const uint8_t *memory, uint8_t lcdc, uint8_t ly,
+		     uint8_t *window_line);
+
+
+/* Mark the tile with the byte at `address`, in the tile data, to be
+ * decoded again. For the bus, on every write there. */
+static inline void ppu_tile_written(ppu_t *ppu, uint16_t address)
+{
+    unsigned tile = (address - PPU_TILE_DATA) >> 4;
+
+    ppu->stale[tile / 64] |= (uint64_t)1 << (tile % 64);
+}
+
+#endif /* __PPU_H__ */
@@ -2,6 +2,9 @@
 #ifndef __REGISTER_H__
 #define __REGISTER_H__
 
+#include <stdbool.h>
+#include <stdint.h>
+
 typedef enum {
     REGISTER_NO_REGISTER = 0,
     REGISTER_AF,
@@ -20,5 +23,87 @@ typedef enum {
     REGISTER_PC,
 } register_e;
 
+/*
+ * CPU register file.
+ *
+ * The registers are stored as one byte array so that any register_e can
+ * be turned into an array index with a constant lookup. Pairs are laid out
+ * in host byte order so that r16[] (and the AF/BC/DE/HL names) read the
+ * high register from the upper byte, e.g. BC == B << 8 | C.
+ */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+enum {
+    REG8_A, REG8_F, REG8_B, REG8_C, REG8_D, REG8_E, REG8_H, REG8_L,
+};
+#else
+enum {
+    REG8_F, REG8_A, REG8_C, REG8_B, REG8_E, REG8_D, REG8_L, REG8_H,
+};
+#endif
+
+enum {
+    REG16_AF, REG16_BC, REG16_DE, REG16_HL, REG16_SP, REG16_PC,
+    REG16_COUNT,
+};
+
+typedef struct {
+    union {
+	uint8_t r8[REG16_COUNT * 2];
+	uint16_t r16[REG16_COUNT];
+	struct {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	    uint8_t A, F, B, C, D, E, H, L;
+#else
+	    uint8_t F, A, C, B, E, D, L, H;
+#endif
+	};
+	struct {
+	    uint16_t AF, BC, DE, HL;
+	    uint16_t SP; /* Stack Pointer */
+	    uint16_t PC; /* Program Counter */
+	};
+    };
+    uint16_t IR; /* Instruction Register */
+} registers_t;
+
+/* register_e to r8[] index, for the 8-bit registers */
+static const uint8_t register_r8_index[] =
+{
+    [REGISTER_A] = REG8_A, [REGISTER_F] = REG8_F,
+    [REGISTER_B] = REG8_B, [REGISTER_C] = REG8_C,
+    [REGISTER_D] = REG8_D, [REGISTER_E] = REG8_E,
+    [REGISTER_H] = REG8_H, [REGISTER_L] = REG8_L,
+};
+
+/* register_e to r16[] index, for the pairs, SP and PC */
+static const uint8_t register_r16_index[] =
+{
+    [REGISTER_AF] = REG16_AF, [REGISTER_BC] = REG16_BC,
+    [REGISTER_DE] = REG16_DE, [REGISTER_HL] = REG16_HL,
+    [REGISTER_SP] = REG16_SP, [REGISTER_PC] = REG16_PC,
+};
+
+static const bool register_is_16bit[] =
+{
+    [REGISTER_AF] = true, [REGISTER_BC] = true, [REGISTER_DE] = true,
+    [REGISTER_HL] = true, [REGISTER_SP] = true, [REGISTER_PC] = true,
+};
+
+static inline uint16_t register_read(const registers_t *reg, register_e r)
+{
+    if (register_is_16bit[r])
+	return reg->r16[register_r16_index[r]];
+    return reg->r8[register_r8_index[r]];
+}
+
+
+static inline void register_write(registers_t *reg, register_e r, uint16_t value)
+{
+    if (register_is_16bit[r])
+	reg->r16[register_r16_index[r]] = value;
+    else
+	reg->r8[register_r8_index[r]] = (uint8_t)value;
+}
+
 char* register_to_string(register_e reg);
 #endif /* __INSTRUCTION_H__ */
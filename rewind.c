@@ -0,0 +1,433 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gb.h"
+#include "rewind.h"
+#include "snapshot.h"
+
+/*
+ * States are serialized with snapshot_state_save() and handled as 64-bit
+ * words. A delta is the XOR of a state and the one captured before it; a
+ * keyframe is the same against an all-zero state, so both are encoded and
+ * applied alike. The encoding is a sequence of
+ *
+ *   <zero words> <literal words> <that many literal words>
+ *
+ * with the counts as LEB128, until every word of the state is covered. A
+ * literal run ends at the first zero word, so a lone unchanged word costs
+ * two count bytes rather than eight. Zero runs are skipped 32 bytes at a
+ * time with the GCC vector extensions, built for AVX2 as well as the
+ * baseline on x86-64 as in lockstep.c.
+ *
+ * Between captures the newest state is kept decoded, and a capture starts
+ * a write epoch (see gb.h), so the next one only serializes and compares
+ * the pages of RAM and cartridge RAM written since. Each state is a
+ * malloc'd block of its encoding, and the blocks are kept in a ring from
+ * oldest to newest. The oldest is always a keyframe.
+ */
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define REWIND_TARGETS __attribute__((target_clones("avx2", "default")))
+#else
+#define REWIND_TARGETS
+#endif
+
+#define REWIND_VECTOR_WORDS 4
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    bool keyframe;
+} rewind_entry_t;
+
+typedef struct {
+    size_t start;
+    size_t end;
+} range_t;
+
+struct rewind_s {
+    size_t budget;            /* bytes of encoded states kept at most */
+    unsigned interval;        /* states from one keyframe to the next */
+    unsigned since_keyframe;  /* deltas captured since the last keyframe */
+    size_t words;             /* state size in words */
+    const gb_t *source;       /* instance captured last */
+    uint64_t epoch;           /* write epoch started by the last capture */
+    uint64_t *current;
+    uint64_t *previous;       /* the newest state, decoded */
+    uint64_t *zero;
+    uint8_t *scratch;         /* encoder output, worst case */
+
+    rewind_entry_t *entries;
+    size_t capacity;          /* power of 2 */
+    size_t first;
+    size_t count;
+    size_t used;              /* bytes held by entries */
+};
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+static size_t count_put(uint8_t *out, size_t count)
+{
+    size_t length = 0;
+
+    while (count >= 0x80)
+    {
+	out[length++] = (count & 0x7F) | 0x80;
+	count >>= 7;
+    }
+    out[length++] = count;
+    return length;
+}
+
+
+static const uint8_t *count_get(const uint8_t *in, size_t *count)
+{
+    size_t shift = 0;
+
+    *count = 0;
+    do
+    {
+	*count |= (size_t)(*in & 0x7F) << shift;
+	shift += 7;
+    } while (*in++ & 0x80);
+    return in;
+}
+
+
+/*
+ * Encode the XOR of `state` and `base` into `out`, returns its length. Only
+ * the `count` word ranges in `ranges`, in order, are looked at and the
+ * words outside them are taken to be the same.
+ */
+REWIND_TARGETS
+static size_t delta_encode(const uint64_t *state, const uint64_t *base, size_t words,
+			   const range_t *ranges, size_t count, uint8_t *out)
+{
+#if defined(__GNUC__)
+    typedef uint64_t vector_t __attribute__((vector_size(REWIND_VECTOR_WORDS * 8)));
+#endif
+    uint8_t *p = out;
+    size_t last = 0; /* end of the last literal run */
+
+    for (const range_t *range = ranges; range < ranges + count; range++)
+    {
+	size_t i = range->start;
+
+	while (i < range->end)
+	{
+	    size_t literal;
+
+	    while (i < range->end && state[i] == base[i])
+	    {
+		i++;
+#if defined(__GNUC__)
+		/* whole vectors at a time once aligned to one */
+		while (i % REWIND_VECTOR_WORDS == 0 && i + REWIND_VECTOR_WORDS <= range->end)
+		{
+		    vector_t a, b, x;
+
+		    memcpy(&a, &state[i], sizeof(a));
+		    memcpy(&b, &base[i], sizeof(b));
+		    x = a ^ b;
+		    if (x[0] | x[1] | x[2] | x[3])
+			break;
+		    i += REWIND_VECTOR_WORDS;
+		}
+#endif
+	    }
+	    if (i == range->end)
+		break;
+
+	    literal = i;
+	    while (i < range->end && state[i] != base[i])
+	    {
+		i++;
+	    }
+	    p += count_put(p, literal - last);
+	    p += count_put(p, i - literal);
+	    for (size_t w = literal; w < i; w++)
+	    {
+		uint64_t x = state[w] ^ base[w];
+		memcpy(p, &x, sizeof(x));
+		p += sizeof(x);
+	    }
+	    last = i;
+	}
+    }
+    p += count_put(p, words - last);
+    p += count_put(p, 0);
+    return p - out;
+}
+
+
+/* The words of the serialized state that `pages` cover, after the ones
+ * before the pages. Returns the number of ranges. */
+static size_t page_ranges(const rewind_t *rewind, const uint64_t *pages, range_t *ranges)
+{
+    size_t first = snapshot_state_pages_offset() / sizeof(uint64_t);
+    size_t count = 0;
+
+    ranges[count++] = (range_t){ 0, first };
+    for (size_t i = 0; i < GB_STATE_PAGES / 64; i++)
+    {
+	for (uint64_t bits = pages[i]; bits; bits &= bits - 1)
+	{
+	    size_t page = i * 64 + __builtin_ctzll(bits);
+	    size_t start = first + (page << GB_PAGE_SHIFT) / sizeof(uint64_t);
+
+	    if (ranges[count - 1].end == start)
+		ranges[count - 1].end = start + GB_PAGE_SIZE / sizeof(uint64_t);
+	    else
+		ranges[count++] = (range_t){ start, start + GB_PAGE_SIZE / sizeof(uint64_t) };
+	}
+    }
+    if (ranges[count - 1].end == first + (GB_STATE_PAGES << GB_PAGE_SHIFT) / sizeof(uint64_t))
+	ranges[count - 1].end = rewind->words;
+    return count;
+}
+
+
+/* Words of the serialized state holding the pages `gb` has. Cartridge
+ * RAM takes the room of the largest, and a keyframe leaves what is past
+ * the instance's own as zeros. */
+static size_t state_words(const gb_t *gb)
+{
+    return (snapshot_state_pages_offset() + (gb_state_pages(gb) << GB_PAGE_SHIFT)) /
+	   sizeof(uint64_t);
+}
+
+
+/* XOR an encoding from delta_encode() into `state` */
+static void delta_apply(uint64_t *state, size_t words, const uint8_t *in)
+{
+    size_t i = 0;
+
+    while (i < words)
+    {
+	size_t zero, literal;
+
+	in = count_get(in, &zero);
+	in = count_get(in, &literal);
+	i += zero;
+	for (; literal; literal--, i++)
+	{
+	    uint64_t x;
+	    memcpy(&x, in, sizeof(x));
+	    state[i] ^= x;
+	    in += sizeof(x);
+	}
+    }
+}
+
+
+static rewind_entry_t *entry_at(rewind_t *rewind, size_t index)
+{
+    return &rewind->entries[(rewind->first + index) & (rewind->capacity - 1)];
+}
+
+
+static bool entry_push(rewind_t *rewind, rewind_entry_t entry)
+{
+    if (rewind->count == rewind->capacity)
+    {
+	size_t capacity = rewind->capacity ? rewind->capacity * 2 : 256;
+	rewind_entry_t *entries = malloc(capacity * sizeof(rewind_entry_t));
+
+	if (!entries)
+	    return false;
+	for (size_t i = 0; i < rewind->count; i++)
+	{
+	    entries[i] = *entry_at(rewind, i);
+	}
+	free(rewind->entries);
+	rewind->entries = entries;
+	rewind->capacity = capacity;
+	rewind->first = 0;
+    }
+    *entry_at(rewind, rewind->count++) = entry;
+    rewind->used += entry.size;
+    return true;
+}
+
+
+static void entry_drop_oldest(rewind_t *rewind)
+{
+    rewind_entry_t *entry = entry_at(rewind, 0);
+
+    rewind->used -= entry->size;
+    free(entry->data);
+    rewind->first = (rewind->first + 1) & (rewind->capacity - 1);
+    rewind->count--;
+}
+
+
+static void entry_drop_newest(rewind_t *rewind)
+{
+    rewind_entry_t *entry = entry_at(rewind, rewind->count - 1);
+
+    rewind->used -= entry->size;
+    free(entry->data);
+    rewind->count--;
+}
+
+
+/* Drop the oldest keyframes with their deltas until the budget is met,
+ * always keeping the newest keyframe */
+static void evict(rewind_t *rewind)
+{
+    while (rewind->used > rewind->budget)
+    {
+	size_t group = 1;
+
+	while (group < rewind->count && !entry_at(rewind, group)->keyframe)
+	    group++;
+	if (group == rewind->count)
+	    break;
+	for (; group; group--)
+	{
+	    entry_drop_oldest(rewind);
+	}
+    }
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/*
+ * A rewind buffer keeping encoded states within `budget` bytes, with a
+ * keyframe every `keyframe_interval` states. The states since the newest
+ * keyframe are kept even past the budget. NULL if out of memory.
+ */
+rewind_t *rewind_create(size_t budget, unsigned keyframe_interval)
+{
+    rewind_t *rewind = calloc(1, sizeof(rewind_t));
+    size_t words = (snapshot_state_size() + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    if (!rewind)
+	return NULL;
+    rewind->budget = budget;
+    rewind->interval = keyframe_interval ? keyframe_interval : 1;
+    rewind->words = words;
+    rewind->current = calloc(words, sizeof(uint64_t));
+    rewind->previous = calloc(words, sizeof(uint64_t));
+    rewind->zero = calloc(words, sizeof(uint64_t));
+    /* two counts of at most 3 bytes to every literal word, and a final pair */
+    rewind->scratch = malloc(words * (sizeof(uint64_t) + 6) + 6);
+    if (!rewind->current || !rewind->previous || !rewind->zero || !rewind->scratch)
+    {
+	rewind_free(rewind);
+	return NULL;
+    }
+    return rewind;
+}
+
+
+void rewind_free(rewind_t *rewind)
+{
+    if (!rewind)
+	return;
+    while (rewind->count)
+	entry_drop_oldest(rewind);
+    free(rewind->entries);
+    free(rewind->current);
+    free(rewind->previous);
+    free(rewind->zero);
+    free(rewind->scratch);
+    free(rewind);
+}
+
+
+/* Capture the state of `gb` as the newest one. Call between runs. Returns
+ * false if out of memory, leaving the buffer as it was. */
+bool rewind_capture(rewind_t *rewind, gb_t *gb)
+{
+    bool keyframe = rewind->count == 0 || rewind->since_keyframe + 1 >= rewind->interval;
+    rewind_entry_t entry = { .keyframe = keyframe };
+    uint64_t pages[GB_STATE_PAGES / 64];
+    range_t ranges[GB_STATE_PAGES + 1];
+    size_t count;
+
+    /* current and previous hold the same state in between captures, so
+     * only what was written since the last one needs looking at */
+    snapshot_state_save(gb, rewind->current, rewind->source == gb ? rewind->epoch : 0, pages);
+    count = page_ranges(rewind, pages, ranges);
+    if (keyframe)
+    {
+	range_t all = { 0, state_words(gb) };
+	entry.size = delta_encode(rewind->current, rewind->zero, rewind->words, &all, 1,
+				  rewind->scratch);
+    }
+    else
+    {
+	entry.size = delta_encode(rewind->current, rewind->previous, rewind->words, ranges, count,
+				  rewind->scratch);
+    }
+
+    entry.data = malloc(entry.size);
+    if (!entry.data || !entry_push(rewind, entry))
+    {
+	free(entry.data);
+	/* start over from a keyframe, the pages written are forgotten */
+	rewind->source = NULL;
+	rewind->since_keyframe = rewind->interval;
+	return false;
+    }
+    memcpy(entry.data, rewind->scratch, entry.size);
+
+    for (size_t i = 0; i < count; i++)
+    {
+	memcpy(&rewind->previous[ranges[i].start], &rewind->current[ranges[i].start],
+	       (ranges[i].end - ranges[i].start) * sizeof(uint64_t));
+    }
+    rewind->source = gb;
+    rewind->epoch = gb_epoch_start(gb);
+    rewind->since_keyframe = keyframe ? 0 : rewind->since_keyframe + 1;
+    evict(rewind);
+    return true;
+}
+
+
+/*
+ * Put `gb` back in the state captured `steps` captures before the newest,
+ * 0 being the newest itself, and forget the ones after it. Returns false
+ * if the buffer doesn't go back that far.
+ */
+bool rewind_back(rewind_t *rewind, gb_t *gb, size_t steps)
+{
+    size_t target, keyframe;
+
+    if (steps >= rewind->count)
+	return false;
+    target = rewind->count - 1 - steps;
+    for (keyframe = target; !entry_at(rewind, keyframe)->keyframe; keyframe--)
+	;
+
+    memset(rewind->previous, 0, rewind->words * sizeof(uint64_t));
+    for (size_t i = keyframe; i <= target; i++)
+    {
+	delta_apply(rewind->previous, rewind->words, entry_at(rewind, i)->data);
+    }
+    snapshot_state_load(gb, rewind->previous);
+    memcpy(rewind->current, rewind->previous, rewind->words * sizeof(uint64_t));
+    rewind->source = gb;
+    rewind->epoch = gb_epoch_start(gb);
+
+    while (rewind->count > target + 1)
+	entry_drop_newest(rewind);
+    rewind->since_keyframe = target - keyframe;
+    return true;
+}
+
+
+/* States held */
+size_t rewind_count(const rewind_t *rewind)
+{
+    return rewind->count;
+}
+
+
+/* Bytes held by the encoded states */
+size_t rewind_memory(const rewind_t *rewind)
+{
+    return rewind->used;
+}
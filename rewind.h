@@ -0,0 +1,29 @@
+#ifndef __REWIND_H__
+#define __REWIND_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cpu.h"
+
+/*
+ * Rewind buffer: the most recent states of an instance, captured e.g. once
+ * a frame, kept compressed within a memory budget. Every Nth state is a
+ * keyframe that stands on its own and the rest are stored as the XOR of
+ * the state before them, which is mostly zero, with the zero runs left
+ * out. Once the budget is used up the oldest keyframe goes, along with the
+ * states that depend on it.
+ */
+typedef struct rewind_s rewind_t;
+
+#define REWIND_DEFAULT_BUDGET   (32 << 20)
+#define REWIND_DEFAULT_INTERVAL 60
+
+rewind_t *rewind_create(size_t budget, unsigned keyframe_interval);
+void rewind_free(rewind_t *rewind);
+bool rewind_capture(rewind_t *rewind, gb_t *gb);
+bool rewind_back(rewind_t *rewind, gb_t *gb, size_t steps);
+size_t rewind_count(const rewind_t *rewind);
+size_t rewind_memory(const rewind_t *rewind);
+
+#endif /* __REWIND_H__ */
@@ -0,0 +1,177 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "save.h"
+
+/*
+ * The syncer sleeps on a condition variable until the interval is up or
+ * it is woken by save_sync() or save_close(). It never holds the lock
+ * while msync() runs, and save_sync() only takes it to wake the syncer
+ * when no request is pending yet, so asking for a sync costs the emulator
+ * an atomic exchange. The kernel knows which pages of the mapping are
+ * dirty, so a sync with nothing written costs next to nothing.
+ *
+ * A sync write-protects the pages it cleans, and the next write to one
+ * faults, so syncs are at least SAVE_SYNC_GAP_MS apart however often a
+ * game asks: requests made in between are served together once it's up.
+ */
+#define SAVE_SYNC_GAP_MS 100
+
+struct save_s {
+    uint8_t *memory;
+    size_t size;
+    unsigned interval_ms;  /* 0 to only sync when asked to */
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    atomic_bool requested;
+    bool closing;          /* under lock */
+    pthread_t syncer;
+};
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+static void deadline_after(struct timespec *ts, unsigned ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000)
+    {
+	ts->tv_sec++;
+	ts->tv_nsec -= 1000000000;
+    }
+}
+
+
+static void *syncer_main(void *arg)
+{
+    save_t *save = arg;
+    struct timespec deadline;
+    struct timespec gap = { SAVE_SYNC_GAP_MS / 1000, SAVE_SYNC_GAP_MS % 1000 * 1000000L };
+    bool closing;
+
+    deadline_after(&deadline, save->interval_ms);
+    do
+    {
+	int waited = 0;
+
+	pthread_mutex_lock(&save->lock);
+	while (!atomic_load(&save->requested) && !save->closing && waited != ETIMEDOUT)
+	{
+	    if (save->interval_ms)
+		waited = pthread_cond_timedwait(&save->wake, &save->lock, &deadline);
+	    else
+		pthread_cond_wait(&save->wake, &save->lock);
+	}
+	closing = save->closing;
+	pthread_mutex_unlock(&save->lock);
+
+	/* cleared first, so writes made during the sync ask for another */
+	atomic_store(&save->requested, false);
+	msync(save->memory, save->size, MS_SYNC);
+	if (waited == ETIMEDOUT)
+	    deadline_after(&deadline, save->interval_ms);
+	if (!closing)
+	    nanosleep(&gap, NULL);
+    } while (!closing);
+
+    return NULL;
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/*
+ * Map `size` bytes of the save file at `path`, created or grown with
+ * zeros as needed, and start syncing it every `interval_ms`, or only when
+ * asked to for 0. Returns NULL if the file or the syncer can't be set up.
+ */
+save_t *save_open(const char *path, size_t size, unsigned interval_ms)
+{
+    pthread_condattr_t attr;
+    struct stat st;
+    save_t *save;
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+
+    if (fd < 0)
+	return NULL;
+    save = malloc(sizeof(save_t));
+    if (!save || fstat(fd, &st) != 0 ||
+	((size_t)st.st_size < size && ftruncate(fd, size) != 0))
+    {
+	free(save);
+	close(fd);
+	return NULL;
+    }
+    save->memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (save->memory == MAP_FAILED)
+    {
+	free(save);
+	return NULL;
+    }
+
+    save->size = size;
+    save->interval_ms = interval_ms;
+    atomic_init(&save->requested, false);
+    save->closing = false;
+    pthread_mutex_init(&save->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&save->wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&save->syncer, NULL, syncer_main, save) != 0)
+    {
+	pthread_cond_destroy(&save->wake);
+	pthread_mutex_destroy(&save->lock);
+	munmap(save->memory, size);
+	free(save);
+	return NULL;
+    }
+    return save;
+}
+
+
+/* The mapped file, to be read and written as cartridge RAM */
+uint8_t *save_memory(save_t *save)
+{
+    return save->memory;
+}
+
+
+/* Have the syncer write the file out soon. Doesn't wait for the disk. */
+void save_sync(save_t *save)
+{
+    if (atomic_exchange(&save->requested, true))
+	return;
+    pthread_mutex_lock(&save->lock);
+    pthread_cond_signal(&save->wake);
+    pthread_mutex_unlock(&save->lock);
+}
+
+
+/* Write the file out a last time, then stop the syncer and unmap it */
+void save_close(save_t *save)
+{
+    if (!save)
+	return;
+    pthread_mutex_lock(&save->lock);
+    save->closing = true;
+    pthread_cond_signal(&save->wake);
+    pthread_mutex_unlock(&save->lock);
+    pthread_join(save->syncer, NULL);
+
+    pthread_cond_destroy(&save->wake);
+    pthread_mutex_destroy(&save->lock);
+    munmap(save->memory, save->size);
+    free(save);
+}
@@ -0,0 +1,25 @@
+#ifndef __SAVE_H__
+#define __SAVE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Battery-backed cartridge RAM kept in a save file. The file is mapped
+ * shared and the emulator reads and writes the mapping in place, so the
+ * game's writes are in the host's page cache at once and outlive a crash
+ * of the emulator. A background thread msync()s the mapping to disk every
+ * `interval_ms` and whenever asked to with save_sync(), e.g. when the game
+ * disables its RAM after writing it, so the emulator never waits on the
+ * disk. Each open save has its own thread.
+ */
+#define SAVE_INTERVAL_DEFAULT_MS 1000
+
+typedef struct save_s save_t;
+
+save_t *save_open(const char *path, size_t size, unsigned interval_ms);
+uint8_t *save_memory(save_t *save);
+void save_sync(save_t *save);
+void save_close(save_t *save);
+
+#endif /* __SAVE_H__ */
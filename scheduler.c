@@ -0,0 +1,88 @@
+#include <stddef.h>
+
+#include "scheduler.h"
+
+/*
+ * There are only a handful of event kinds and each has at most one
+ * pending deadline, so the deadlines live in a small array indexed by
+ * event and the earliest one is cached in scheduler->next. That keeps the
+ * check the CPU makes after every instruction to a single compare.
+ */
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+void scheduler_init(scheduler_t *scheduler)
+{
+    for (int i = 0; i < EVENT_COUNT; i++)
+    {
+	scheduler->deadline[i] = SCHEDULER_NEVER;
+	scheduler->handler[i] = NULL;
+	scheduler->context[i] = NULL;
+    }
+    scheduler->next = SCHEDULER_NEVER;
+}
+
+
+void scheduler_register(scheduler_t *scheduler, event_e event,
+			event_handler_t handler, void *context)
+{
+    scheduler->handler[event] = handler;
+    scheduler->context[event] = context;
+}
+
+
+uint64_t scheduler_earliest(const scheduler_t *scheduler)
+{
+    uint64_t earliest = SCHEDULER_NEVER;
+
+    for (int i = 0; i < EVENT_COUNT; i++)
+    {
+	if (scheduler->deadline[i] < earliest)
+	    earliest = scheduler->deadline[i];
+    }
+    return earliest;
+}
+
+
+/* Set, or move, the deadline of `event` */
+void scheduler_schedule(scheduler_t *scheduler, event_e event, uint64_t when)
+{
+    scheduler->deadline[event] = when;
+    if (when < scheduler->next)
+	scheduler->next = when;
+}
+
+
+void scheduler_cancel(scheduler_t *scheduler, event_e event)
+{
+    scheduler->deadline[event] = SCHEDULER_NEVER;
+    /* scheduler->next is left early, scheduler_run() corrects it */
+}
+
+
+/* Run every event due at or before `now`, earliest first */
+void scheduler_run(scheduler_t *scheduler, uint64_t now)
+{
+    for (;;)
+    {
+	uint64_t when = SCHEDULER_NEVER;
+	int event = -1;
+
+	for (int i = 0; i < EVENT_COUNT; i++)
+	{
+	    if (scheduler->deadline[i] < when)
+	    {
+		when = scheduler->deadline[i];
+		event = i;
+	    }
+	}
+	if (event < 0 || when > now)
+	{
+	    scheduler->next = when;
+	    return;
+	}
+
+	scheduler->deadline[event] = SCHEDULER_NEVER;
+	scheduler->handler[event](scheduler->context[event], when);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+#include <stdint.h>
+
+/*
+ * Cycle-ordered event scheduler. Each subsystem owns one event slot and
+ * keeps it set to the guest cycle of the next thing it has to do; the CPU
+ * runs without looking at any of them until its cycle counter reaches
+ * scheduler->next, then scheduler_run() calls the handlers that are due.
+ */
+#define SCHEDULER_NEVER UINT64_MAX
+
+typedef enum {
+    EVENT_TIMER,  /* TIMA overflow */
+    EVENT_PPU,    /* LCD mode change */
+    EVENT_SERIAL, /* serial bit shifted */
+    EVENT_DMA,    /* OAM DMA complete */
+    EVENT_RUN_END, /* end of a cpu_run_cycles() budget */
+    EVENT_COUNT,
+} event_e;
+
+/* Called with the context it was registered with and the cycle the event
+ * was due at, which may be before the cycle it runs at */
+typedef void (*event_handler_t)(void *context, uint64_t when);
+
+typedef struct {
+    uint64_t next;                   /* earliest deadline, 0 when kicked */
+    uint64_t deadline[EVENT_COUNT];  /* SCHEDULER_NEVER when idle */
+    event_handler_t handler[EVENT_COUNT];
+    void *context[EVENT_COUNT];
+} scheduler_t;
+
+void scheduler_init(scheduler_t *scheduler);
+void scheduler_register(scheduler_t *scheduler, event_e event,
+			event_handler_t handler, void *context);
+void scheduler_schedule(scheduler_t *scheduler, event_e event, uint64_t when);
+void scheduler_cancel(scheduler_t *scheduler, event_e event);
+uint64_t scheduler_earliest(const scheduler_t *scheduler);
+void scheduler_run(scheduler_t *scheduler, uint64_t now);
+
+
+/* Make the CPU call scheduler_run() at the next instruction boundary,
+ * e.g. when an interrupt may have become pending */
+static inline void scheduler_kick(scheduler_t *scheduler)
+{
+    scheduler->next = 0;
+}
+
+#endif /* __SCHEDULER_H__ */
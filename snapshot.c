@@ -0,0 +1,283 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gb.h"
+#include "snapshot.h"
+
+/*
+ * Each take gets a serial number that is never handed out again, and the
+ * instance records the one its RAM is relative to in snapshot_base, so a
+ * snapshot freed and another allocated in its place can't be mistaken for
+ * it. Taking and restoring start a write epoch, and the pages stamped with
+ * it or later are the ones written since. Taking again to the same
+ * snapshot is incremental as well. Pages a restore changes are stamped
+ * for whoever else follows the epochs. The pages from GB_IO_PAGE up to
+ * the end of RAM[] are always copied.
+ *
+ * The state is RAM[] and the cartridge's RAM, as pages one after the other
+ * (see gb_state_page()), and everything else. Cartridge RAM of any size
+ * takes the room of the largest there is, so one instance's state fits
+ * in another's buffer.
+ */
+
+/* Everything but memory. The I/O state's pointers are left NULL, they are
+ * the instance's own. */
+typedef struct {
+    registers_t reg;
+    lazy_flags_t flags;
+    bool ime;
+    bool halted;
+    uint64_t cycles;
+    uint64_t next;
+    uint64_t deadline[EVENT_COUNT];
+    io_t io;
+    mbc_t mbc;
+} machine_t;
+
+/* The saved state, which is also the serialized form */
+typedef struct {
+    machine_t machine;
+    _Alignas(8) uint8_t pages[GB_STATE_PAGES][GB_PAGE_SIZE];
+} state_t;
+
+struct snapshot_s {
+    uint64_t serial;  /* 0 until taken */
+    state_t state;
+};
+
+static atomic_uint_fast64_t snapshot_serial;
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+
+static void machine_save(machine_t *state, const gb_t *gb)
+{
+    state->reg = gb->reg;
+    state->flags = gb->flags;
+    state->ime = gb->ime;
+    state->halted = gb->halted;
+    state->cycles = gb->cycles;
+    state->next = gb->scheduler.next;
+    memcpy(state->deadline, gb->scheduler.deadline, sizeof(state->deadline));
+    state->io = gb->io;
+    state->io.scheduler = NULL;
+    state->io.memory = NULL;
+    state->io.bus = NULL;
+    state->io.ppu = NULL;
+    state->mbc = gb->mbc;
+}
+
+
+static void machine_load(gb_t *gb, const machine_t *state)
+{
+    scheduler_t *scheduler = gb->io.scheduler;
+    uint8_t *memory = gb->io.memory;
+    const bus_page_t *bus = gb->io.bus;
+    ppu_t *ppu = gb->io.ppu;
+
+    gb->reg = state->reg;
+    gb->flags = state->flags;
+    gb->ime = state->ime;
+    gb->halted = state->halted;
+    gb->cycles = state->cycles;
+    gb->scheduler.next = state->next;
+    memcpy(gb->scheduler.deadline, state->deadline, sizeof(state->deadline));
+    gb->io = state->io;
+    gb->io.scheduler = scheduler;
+    gb->io.memory = memory;
+    gb->io.bus = bus;
+    gb->io.ppu = ppu;
+    /* the cartridge stays inserted, with its mapper's registers as they
+     * were, which may switch banks */
+    if (gb->cart)
+    {
+	uint8_t kind = gb->mbc.kind;
+
+	gb->mbc = state->mbc;
+	gb->mbc.kind = kind;
+	mbc_map(gb);
+    }
+}
+
+
+/* Bitmap of the pages written since epoch `since`, including the ones
+ * that are always copied */
+static void dirty_pages(const gb_t *gb, uint64_t since, uint64_t *dirty)
+{
+    memset(dirty, 0, GB_STATE_PAGES / 8);
+    for (size_t page = 0; page < GB_PAGES; page++)
+    {
+	if (gb->page_epoch[page] >= since || page >= GB_IO_PAGE)
+	    dirty[page / 64] |= 1ULL << (page % 64);
+    }
+    for (size_t page = GB_PAGES; page < gb_state_pages(gb); page++)
+    {
+	if (gb_state_page_written(gb, page, since))
+	    dirty[page / 64] |= 1ULL << (page % 64);
+    }
+}
+
+
+/* Copy the pages set in `dirty` from `gb` to `state` */
+static void pages_save(state_t *state, const gb_t *gb, uint64_t *dirty)
+{
+    for (size_t i = 0; i < GB_STATE_PAGES / 64; i++)
+    {
+	for (; dirty[i]; dirty[i] &= dirty[i] - 1)
+	{
+	    size_t page = i * 64 + __builtin_ctzll(dirty[i]);
+
+	    memcpy(state->pages[page], gb_state_page(gb, page), GB_PAGE_SIZE);
+	}
+    }
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/* An empty snapshot, to be taken before it is restored. NULL if out of
+ * memory. */
+snapshot_t *snapshot_create()
+{
+    return calloc(1, sizeof(snapshot_t));
+}
+
+
+void snapshot_free(snapshot_t *snapshot)
+{
+    free(snapshot);
+}
+
+
+/* Save the state of `gb` in `snapshot`, replacing what it held. Call
+ * between runs, not from inside one. */
+void snapshot_take(snapshot_t *snapshot, gb_t *gb)
+{
+    uint64_t dirty[GB_STATE_PAGES / 64];
+
+    if (snapshot->serial != 0 && snapshot->serial == gb->snapshot_base)
+    {
+	dirty_pages(gb, gb->snapshot_epoch, dirty);
+	pages_save(&snapshot->state, gb, dirty);
+    }
+    else
+    {
+	memcpy(snapshot->state.pages, gb->RAM, sizeof(gb->RAM));
+	if (gb->cart_ram_size)
+	    memcpy(snapshot->state.pages[GB_PAGES], gb->cart_ram, gb->cart_ram_size);
+    }
+    machine_save(&snapshot->state.machine, gb);
+
+    snapshot->serial = atomic_fetch_add(&snapshot_serial, 1) + 1;
+    gb->snapshot_base = snapshot->serial;
+    gb->snapshot_epoch = gb_epoch_start(gb);
+}
+
+
+/*
+ * Put `gb` back in the state saved in `snapshot`, which may have been taken
+ * from another instance. Returns the number of pages of RAM and cartridge
+ * RAM copied back.
+ */
+size_t snapshot_restore(const snapshot_t *snapshot, gb_t *gb)
+{
+    uint64_t dirty[GB_STATE_PAGES / 64];
+    size_t restored = 0;
+
+    if (snapshot->serial == 0)
+	return 0;
+
+    if (snapshot->serial == gb->snapshot_base)
+	dirty_pages(gb, gb->snapshot_epoch, dirty);
+    else
+	dirty_pages(gb, 0, dirty);
+    for (size_t i = 0; i < GB_STATE_PAGES / 64; i++)
+    {
+	for (; dirty[i]; dirty[i] &= dirty[i] - 1, restored++)
+	{
+	    size_t page = i * 64 + __builtin_ctzll(dirty[i]);
+
+	    cpu_page_load(gb, page, snapshot->state.pages[page]);
+	}
+    }
+    machine_load(gb, &snapshot->state.machine);
+
+    gb->snapshot_base = snapshot->serial;
+    gb->snapshot_epoch = gb_epoch_start(gb);
+    return restored;
+}
+
+
+/* Size of the serialized state */
+size_t snapshot_state_size()
+{
+    return sizeof(state_t);
+}
+
+
+/* Where the pages start in the serialized state, a multiple of 8. They are
+ * stored as is, one after the other, GB_STATE_PAGES of them. */
+size_t snapshot_state_pages_offset()
+{
+    return offsetof(state_t, pages);
+}
+
+
+/*
+ * Serialize the state of `gb` into the snapshot_state_size() bytes at
+ * `data`. Pages not written since write epoch `since` are taken to be
+ * there already and left alone, 0 serializes all of them. If `pages` isn't
+ * NULL, the pages copied are set in it, a bit each of GB_STATE_PAGES.
+ * Call between runs, as with snapshot_take().
+ */
+void snapshot_state_save(const gb_t *gb, void *data, uint64_t since, uint64_t *pages)
+{
+    state_t *state = data;
+    uint64_t dirty[GB_STATE_PAGES / 64];
+
+    machine_save(&state->machine, gb);
+    dirty_pages(gb, since, dirty);
+    if (pages)
+	memcpy(pages, dirty, sizeof(dirty));
+    pages_save(state, gb, dirty);
+}
+
+
+/* Put `gb` in the state serialized at `data`. It is no longer relative to
+ * any snapshot, so the next restore copies all of its pages. */
+void snapshot_state_load(gb_t *gb, const void *data)
+{
+    const state_t *state = data;
+
+    for (size_t page = 0; page < gb_state_pages(gb); page++)
+    {
+	cpu_page_load(gb, page, state->pages[page]);
+    }
+    machine_load(gb, &state->machine);
+    gb->snapshot_base = 0;
+}
+
+
+/* Size of the part of the serialized state before the pages, which can also be
+ * saved and loaded on its own */
+size_t snapshot_machine_size()
+{
+    return sizeof(machine_t);
+}
+
+
+/* Save everything but memory into the snapshot_machine_size() bytes at
+ * `data` */
+void snapshot_machine_save(const gb_t *gb, void *data)
+{
+    machine_save(data, gb);
+}
+
+
+void snapshot_machine_load(gb_t *gb, const void *data)
+{
+    machine_load(gb, data);
+}
@@ -0,0 +1,40 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+/*
+ * Snapshots of an instance's machine state, for going back to a checkpoint
+ * over and over, e.g. to reset an episode, RAM and cartridge RAM included.
+ * The bus marks each 256-byte page it writes as dirty, so restoring the
+ * snapshot an instance was last taken to or restored from only copies back
+ * the pages written since. Restoring any other snapshot copies them all.
+ * Settings such as the dynarec, idle skipping and tracing are left as they
+ * are, and so are decoded blocks, except for those whose code the restore
+ * changed.
+ *
+ * The same state can be serialized into a flat buffer, for keeping many of
+ * them compactly as rewind.c does, and brought up to date by only copying
+ * the pages written since a write epoch (see gb.h). The layout is the
+ * host's own, so the buffer is only good for the build that wrote it.
+ */
+typedef struct snapshot_s snapshot_t;
+
+snapshot_t *snapshot_create();
+void snapshot_free(snapshot_t *snapshot);
+void snapshot_take(snapshot_t *snapshot, gb_t *gb);
+size_t snapshot_restore(const snapshot_t *snapshot, gb_t *gb);
+
+size_t snapshot_state_size();
+size_t snapshot_state_pages_offset();
+void snapshot_state_save(const gb_t *gb, void *data, uint64_t since, uint64_t *pages);
+void snapshot_state_load(gb_t *gb, const void *data);
+
+size_t snapshot_machine_size();
+void snapshot_machine_save(const gb_t *gb, void *data);
+void snapshot_machine_load(gb_t *gb, const void *data);
+
+#endif /* __SNAPSHOT_H__ */
@@ -0,0 +1,414 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gb.h"
+#include "snapshot.h"
+#include "statetree.h"
+
+/*
+ * Pages live in two chained hash tables, one by contents for sharing
+ * identical pages and one by id, and nodes in a third by id. Ids are never
+ * handed out twice, in any tree, so an instance can keep the ids of its
+ * node and that node's pages in gb->tree_node and gb->tree_page without
+ * holding on to them: if the node is gone, its pages are looked up one by
+ * one, and if a page is gone too, or belongs to another tree, it is hashed
+ * again.
+ * Capturing and loading start a write epoch in gb->tree_epoch to tell the
+ * pages written since. The pages from GB_IO_PAGE up to the end of RAM[] are
+ * always hashed and copied. A node holds the pages of RAM[] then those of
+ * the cartridge's RAM, as many as the instance captured has.
+ */
+#define STATETREE_INITIAL_BUCKETS 1024
+
+typedef struct page_s page_t;
+
+struct page_s {
+    uint64_t id;
+    uint64_t hash;    /* of data */
+    uint32_t refs;    /* nodes holding the page */
+    page_t *next_hash;
+    page_t *next_id;
+    uint8_t data[GB_PAGE_SIZE];
+};
+
+struct statetree_s {
+    page_t **by_hash;
+    page_t **by_id;
+    size_t buckets;   /* of each page table, a power of 2 */
+    size_t pages;
+    statetree_node_t **nodes_by_id;
+    size_t node_buckets;
+    size_t nodes;
+    size_t node_bytes;
+};
+
+struct statetree_node_s {
+    statetree_t *tree;
+    uint64_t id;
+    uint32_t refs;
+    statetree_node_t *next_id;
+    size_t count;
+    page_t **pages;     /* count of them, after machine */
+    uint64_t machine[]; /* snapshot_machine_size() bytes */
+};
+
+static atomic_uint_fast64_t statetree_id;
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+static uint64_t page_hash(const uint8_t *data)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    for (size_t i = 0; i < GB_PAGE_SIZE; i += sizeof(uint64_t))
+    {
+	uint64_t word;
+	memcpy(&word, &data[i], sizeof(word));
+	hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+	hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+
+static size_t id_hash(uint64_t id)
+{
+    return id * 0x9E3779B97F4A7C15ULL >> 32;
+}
+
+
+static size_t id_bucket(const statetree_t *tree, uint64_t id)
+{
+    return id_hash(id) & (tree->buckets - 1);
+}
+
+
+static page_t *page_find_id(const statetree_t *tree, uint64_t id)
+{
+    page_t *page;
+
+    for (page = tree->by_id[id_bucket(tree, id)]; page; page = page->next_id)
+    {
+	if (page->id == id)
+	    break;
+    }
+    return page;
+}
+
+
+/* Twice the buckets, returns false if out of memory */
+static bool tables_grow(statetree_t *tree)
+{
+    size_t buckets = tree->buckets * 2;
+    page_t **by_hash = calloc(buckets, sizeof(page_t *));
+    page_t **by_id = calloc(buckets, sizeof(page_t *));
+    page_t **old_hash = tree->by_hash;
+    size_t old_buckets = tree->buckets;
+
+    if (!by_hash || !by_id)
+    {
+	free(by_hash);
+	free(by_id);
+	return false;
+    }
+
+    tree->by_hash = by_hash;
+    tree->buckets = buckets;
+    free(tree->by_id);
+    tree->by_id = by_id;
+    for (size_t i = 0; i < old_buckets; i++)
+    {
+	page_t *page = old_hash[i];
+
+	while (page)
+	{
+	    page_t *next = page->next_hash;
+	    size_t bucket = page->hash & (buckets - 1);
+
+	    page->next_hash = by_hash[bucket];
+	    by_hash[bucket] = page;
+	    bucket = id_bucket(tree, page->id);
+	    page->next_id = by_id[bucket];
+	    by_id[bucket] = page;
+	    page = next;
+	}
+    }
+    free(old_hash);
+    return true;
+}
+
+
+/* The page holding `data`, added if there is none yet. Returns NULL if out
+ * of memory. */
+static page_t *page_intern(statetree_t *tree, const uint8_t *data)
+{
+    uint64_t hash = page_hash(data);
+    page_t *page;
+    size_t bucket;
+
+    for (page = tree->by_hash[hash & (tree->buckets - 1)]; page; page = page->next_hash)
+    {
+	if (page->hash == hash && memcmp(page->data, data, GB_PAGE_SIZE) == 0)
+	    return page;
+    }
+
+    if (tree->pages >= tree->buckets && !tables_grow(tree))
+	return NULL;
+    page = malloc(sizeof(page_t));
+    if (!page)
+	return NULL;
+    page->id = atomic_fetch_add(&statetree_id, 1) + 1;
+    page->hash = hash;
+    page->refs = 0;
+    memcpy(page->data, data, GB_PAGE_SIZE);
+
+    bucket = hash & (tree->buckets - 1);
+    page->next_hash = tree->by_hash[bucket];
+    tree->by_hash[bucket] = page;
+    bucket = id_bucket(tree, page->id);
+    page->next_id = tree->by_id[bucket];
+    tree->by_id[bucket] = page;
+    tree->pages++;
+    return page;
+}
+
+
+static void page_release(statetree_t *tree, page_t *page)
+{
+    page_t **link;
+
+    if (--page->refs)
+	return;
+
+    for (link = &tree->by_hash[page->hash & (tree->buckets - 1)]; *link != page;
+	 link = &(*link)->next_hash)
+	;
+    *link = page->next_hash;
+    for (link = &tree->by_id[id_bucket(tree, page->id)]; *link != page; link = &(*link)->next_id)
+	;
+    *link = page->next_id;
+    tree->pages--;
+    free(page);
+}
+
+
+static statetree_node_t *node_find_id(const statetree_t *tree, uint64_t id)
+{
+    statetree_node_t *node;
+
+    for (node = tree->nodes_by_id[id_hash(id) & (tree->node_buckets - 1)]; node;
+	 node = node->next_id)
+    {
+	if (node->id == id)
+	    break;
+    }
+    return node;
+}
+
+
+/* Add a node to the table by id, returns false if out of memory */
+static bool node_insert(statetree_t *tree, statetree_node_t *node)
+{
+    size_t bucket;
+
+    if (tree->nodes >= tree->node_buckets)
+    {
+	size_t buckets = tree->node_buckets * 2;
+	statetree_node_t **table = calloc(buckets, sizeof(statetree_node_t *));
+
+	if (!table)
+	    return false;
+	for (size_t i = 0; i < tree->node_buckets; i++)
+	{
+	    statetree_node_t *other = tree->nodes_by_id[i];
+
+	    while (other)
+	    {
+		statetree_node_t *next = other->next_id;
+
+		bucket = id_hash(other->id) & (buckets - 1);
+		other->next_id = table[bucket];
+		table[bucket] = other;
+		other = next;
+	    }
+	}
+	free(tree->nodes_by_id);
+	tree->nodes_by_id = table;
+	tree->node_buckets = buckets;
+    }
+
+    bucket = id_hash(node->id) & (tree->node_buckets - 1);
+    node->next_id = tree->nodes_by_id[bucket];
+    tree->nodes_by_id[bucket] = node;
+    tree->nodes++;
+    return true;
+}
+
+
+static size_t machine_words()
+{
+    return (snapshot_machine_size() + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+}
+
+
+static size_t node_size(size_t count)
+{
+    return sizeof(statetree_node_t) + machine_words() * sizeof(uint64_t) +
+	   count * sizeof(page_t *);
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/* An empty tree, NULL if out of memory */
+statetree_t *statetree_create()
+{
+    statetree_t *tree = calloc(1, sizeof(statetree_t));
+
+    if (!tree)
+	return NULL;
+    tree->buckets = STATETREE_INITIAL_BUCKETS;
+    tree->by_hash = calloc(tree->buckets, sizeof(page_t *));
+    tree->by_id = calloc(tree->buckets, sizeof(page_t *));
+    tree->node_buckets = STATETREE_INITIAL_BUCKETS;
+    tree->nodes_by_id = calloc(tree->node_buckets, sizeof(statetree_node_t *));
+    if (!tree->by_hash || !tree->by_id || !tree->nodes_by_id)
+    {
+	statetree_free(tree);
+	return NULL;
+    }
+    return tree;
+}
+
+
+/* Free a tree once all of its nodes have been released */
+void statetree_free(statetree_t *tree)
+{
+    if (!tree)
+	return;
+    free(tree->by_hash);
+    free(tree->by_id);
+    free(tree->nodes_by_id);
+    free(tree);
+}
+
+
+/*
+ * A new node holding the state of `gb`, with one reference for the caller.
+ * Call between runs. Returns NULL if out of memory.
+ */
+statetree_node_t *statetree_capture(statetree_t *tree, gb_t *gb)
+{
+    size_t count = gb_state_pages(gb);
+    statetree_node_t *node = malloc(node_size(count));
+    statetree_node_t *base = node_find_id(tree, gb->tree_node);
+
+    if (!node)
+	return NULL;
+    node->tree = tree;
+    node->id = atomic_fetch_add(&statetree_id, 1) + 1;
+    node->refs = 1;
+    node->count = count;
+    node->pages = (page_t **)&node->machine[machine_words()];
+    if (base && base->count != count)
+	base = NULL;
+
+    for (size_t i = 0; i < count; i++)
+    {
+	page_t *page = NULL;
+
+	if ((i < GB_IO_PAGE || i >= GB_PAGES) && !gb_state_page_written(gb, i, gb->tree_epoch))
+	    page = base ? base->pages[i] : page_find_id(tree, gb->tree_page[i]);
+	if (!page)
+	    page = page_intern(tree, gb_state_page(gb, i));
+	if (!page)
+	{
+	    while (i--)
+		page_release(tree, node->pages[i]);
+	    free(node);
+	    return NULL;
+	}
+	page->refs++;
+	node->pages[i] = page;
+	gb->tree_page[i] = page->id;
+    }
+    tree->node_bytes += node_size(count);
+    if (!node_insert(tree, node))
+    {
+	node->tree->nodes++;
+	statetree_release(node);
+	return NULL;
+    }
+    snapshot_machine_save(gb, node->machine);
+
+    gb->tree_node = node->id;
+    gb->tree_epoch = gb_epoch_start(gb);
+    return node;
+}
+
+
+/* Put `gb` in the state held by `node` */
+void statetree_load(const statetree_node_t *node, gb_t *gb)
+{
+    size_t count = gb_state_pages(gb);
+
+    if (count > node->count)
+	count = node->count;
+    for (size_t i = 0; i < count; i++)
+    {
+	const page_t *page = node->pages[i];
+
+	if ((i >= GB_IO_PAGE && i < GB_PAGES) || gb->tree_page[i] != page->id ||
+	    gb_state_page_written(gb, i, gb->tree_epoch))
+	{
+	    cpu_page_load(gb, i, page->data);
+	    gb->tree_page[i] = page->id;
+	}
+    }
+    snapshot_machine_load(gb, node->machine);
+
+    gb->tree_node = node->id;
+    gb->tree_epoch = gb_epoch_start(gb);
+}
+
+
+/* Another reference to `node`, e.g. for a branch that starts from it */
+statetree_node_t *statetree_retain(statetree_node_t *node)
+{
+    node->refs++;
+    return node;
+}
+
+
+void statetree_release(statetree_node_t *node)
+{
+    statetree_t *tree;
+    statetree_node_t **link;
+
+    if (!node || --node->refs)
+	return;
+    tree = node->tree;
+    for (size_t i = 0; i < node->count; i++)
+    {
+	page_release(tree, node->pages[i]);
+    }
+    for (link = &tree->nodes_by_id[id_hash(node->id) & (tree->node_buckets - 1)]; *link &&
+	 *link != node; link = &(*link)->next_id)
+	;
+    if (*link)
+	*link = node->next_id;
+    tree->nodes--;
+    tree->node_bytes -= node_size(node->count);
+    free(node);
+}
+
+
+void statetree_stats(const statetree_t *tree, statetree_stats_t *stats)
+{
+    stats->nodes = tree->nodes;
+    stats->pages = tree->pages;
+    stats->bytes = tree->node_bytes + tree->pages * sizeof(page_t) +
+		   2 * tree->buckets * sizeof(page_t *) +
+		   tree->node_buckets * sizeof(statetree_node_t *);
+}
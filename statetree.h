@@ -0,0 +1,40 @@
+#ifndef __STATETREE_H__
+#define __STATETREE_H__
+
+#include <stddef.h>
+
+#include "cpu.h"
+
+/*
+ * Copy-on-write machine states for search workloads that branch an instance
+ * many times over. A node is a state split into 256-byte pages of RAM and
+ * cartridge RAM, each reference counted and shared by every node that holds
+ * the same bytes, so nodes captured from one another only cost the pages
+ * that were written in between. Pages with the same contents are stored
+ * once, found by hash.
+ *
+ * Capturing an instance looks up the pages of the node it was last
+ * captured to or loaded from, and only hashes those written since. Loading
+ * a node only copies the pages that differ from that node's. Nodes are
+ * immutable, so branching one is taking another reference to it.
+ *
+ * A tree and its nodes are for one thread at a time.
+ */
+typedef struct statetree_s statetree_t;
+typedef struct statetree_node_s statetree_node_t;
+
+typedef struct {
+    size_t nodes;
+    size_t pages;  /* distinct pages held */
+    size_t bytes;  /* memory held by nodes and pages */
+} statetree_stats_t;
+
+statetree_t *statetree_create();
+void statetree_free(statetree_t *tree);
+statetree_node_t *statetree_capture(statetree_t *tree, gb_t *gb);
+void statetree_load(const statetree_node_t *node, gb_t *gb);
+statetree_node_t *statetree_retain(statetree_node_t *node);
+void statetree_release(statetree_node_t *node);
+void statetree_stats(const statetree_t *tree, statetree_stats_t *stats);
+
+#endif /* __STATETREE_H__ */
@@ -0,0 +1,429 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpu.h"
+#include "gb.h"
+#include "lockstep.h"
+#include "ppu.h"
+#include "register.h"
+#include "rewind.h"
+#include "snapshot.h"
+#include "statetree.h"
+
+/*
+ * Host-side throughput benchmark for the interpreter loops.
+ *
+ * Runs the same instruction count through each execution mode and reports
+ * instructions per second, for the built-in program and for a loop of
+ * arithmetic and stores, and a group of instances of a register-only loop
+ * run one after the other against running them in lockstep, then times
+ * register file access by register_e through a switch against the indexed
+ * lookup, episode resets from a snapshot against copying the whole state
+ * back, rewind captures, state tree branches and drawing scanlines. Trace
+ * output goes to /dev/null; build with CFLAGS=-DTRACE_LEVEL=0 to time
+ * execution without tracing at all. Results are printed on stderr.
+ *
+ * usage: bench [instructions]
+ */
+
+#define BENCH_DEFAULT_INSTRUCTIONS 10000000
+#define BENCH_EPISODE_INSTRUCTIONS 10
+#define BENCH_LANES                16
+
+static double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void bench_step_loop(gb_t *gb, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+	cpu_fetch(gb);
+	cpu_execute(gb);
+    }
+}
+
+
+static void bench_cpu_run(gb_t *gb, size_t count)
+{
+    cpu_run(gb, count);
+}
+
+
+static void bench_cpu_run_cached(gb_t *gb, size_t count)
+{
+    cpu_run_cached(gb, count);
+}
+
+
+static void bench_dynarec(gb_t *gb, size_t count)
+{
+    cpu_set_dynarec(gb, true);
+    cpu_run_cached(gb, count);
+}
+
+
+/* A loop of register arithmetic storing to work RAM, as game code runs,
+ * in place of the built-in program's straight run of code */
+static const uint8_t bench_loop[] =
+{
+    0x21, 0x00, 0xC0,   /* LD HL, 0xC000 */
+    0x06, 0x00,         /* outer: LD B, 0 */
+    0x78,               /* inner: LD A, B */
+    0x81,               /* ADD A, C */
+    0xEE, 0x5A,         /* XOR 0x5A */
+    0x4F,               /* LD C, A */
+    0x77,               /* LD [HL], A */
+    0x2C,               /* INC L */
+    0x05,               /* DEC B */
+    0x20, 0xF6,         /* JR NZ, inner */
+    0x18, 0xF2,         /* JR outer */
+};
+
+
+static void bench_loop_load(gb_t *gb)
+{
+    memcpy(&gb->RAM[0x0100], bench_loop, sizeof(bench_loop));
+    gb->reg.PC = 0x0100;
+}
+
+
+static void bench_loop_run(gb_t *gb, size_t count)
+{
+    bench_loop_load(gb);
+    cpu_run(gb, count);
+}
+
+
+static void bench_loop_cached(gb_t *gb, size_t count)
+{
+    bench_loop_load(gb);
+    cpu_run_cached(gb, count);
+}
+
+
+static void bench_loop_dynarec(gb_t *gb, size_t count)
+{
+    bench_loop_load(gb);
+    cpu_set_dynarec(gb, true);
+    cpu_run_cached(gb, count);
+}
+
+
+/* The loop kept to registers, as lockstep runs it, on BENCH_LANES
+ * instances that start with different C: their results differ but their
+ * branches don't. The lanes share the instruction count, at 4 cycles an
+ * instruction, and don't trace, as the vector part of lockstep doesn't. */
+static const uint8_t bench_lanes_loop[] =
+{
+    0x06, 0x00,         /* outer: LD B, 0 */
+    0x78,               /* inner: LD A, B */
+    0x81,               /* ADD A, C */
+    0xEE, 0x5A,         /* XOR 0x5A */
+    0x4F,               /* LD C, A */
+    0x2C,               /* INC L */
+    0x05,               /* DEC B */
+    0x20, 0xF7,         /* JR NZ, inner */
+    0x18, 0xF3,         /* JR outer */
+};
+
+
+/* `gb` and the instances allocated alongside it to `lanes`, returning how
+ * many there are */
+static size_t bench_lanes_load(gb_t *gb, gb_t **lanes)
+{
+    size_t count;
+
+    for (count = 0; count < BENCH_LANES; count++)
+    {
+	gb_t *lane = count ? gb_alloc() : gb;
+
+	if (!lane)
+	    break;
+	cpu_set_trace_print(lane, false);
+	memcpy(&lane->RAM[0x0100], bench_lanes_loop, sizeof(bench_lanes_loop));
+	lane->reg.PC = 0x0100;
+	lane->reg.C = count * 7;
+	lanes[count] = lane;
+    }
+    return count;
+}
+
+
+static void bench_lanes_free(gb_t **lanes, size_t count)
+{
+    for (size_t i = 1; i < count; i++)
+    {
+	gb_free(lanes[i]);
+    }
+}
+
+
+static void bench_lanes_alone(gb_t *gb, size_t count)
+{
+    gb_t *lanes[BENCH_LANES];
+    size_t lane_count = bench_lanes_load(gb, lanes);
+
+    for (size_t i = 0; i < lane_count; i++)
+    {
+	cpu_run_cycles(lanes[i], count * 4 / BENCH_LANES);
+    }
+    bench_lanes_free(lanes, lane_count);
+}
+
+
+static void bench_lanes_lockstep(gb_t *gb, size_t count)
+{
+    gb_t *lanes[BENCH_LANES];
+    size_t lane_count = bench_lanes_load(gb, lanes);
+    lockstep_t *lockstep = lockstep_create(lanes, lane_count);
+
+    if (lockstep)
+	lockstep_run_cycles(lockstep, count * 4 / BENCH_LANES);
+    lockstep_free(lockstep);
+    bench_lanes_free(lanes, lane_count);
+}
+
+
+/* Short episodes back to back, each reset to the same snapshot, so only
+ * the pages it wrote are copied back. The snapshot is taken once the
+ * built-in program has stored to its own code, which would otherwise cost
+ * a block cache flush every episode. */
+static void bench_snapshot_dirty(gb_t *gb, size_t count)
+{
+    snapshot_t *snapshot = snapshot_create();
+
+    if (!snapshot)
+	return;
+    cpu_set_trace_print(gb, false);
+    cpu_run_cached(gb, BENCH_EPISODE_INSTRUCTIONS);
+    snapshot_take(snapshot, gb);
+    for (size_t i = 0; i < count; i++)
+    {
+	cpu_run_cached(gb, BENCH_EPISODE_INSTRUCTIONS);
+	snapshot_restore(snapshot, gb);
+    }
+    snapshot_free(snapshot);
+}
+
+
+/* The same, alternating between two copies of the snapshot so every reset
+ * copies all of RAM */
+static void bench_snapshot_full(gb_t *gb, size_t count)
+{
+    snapshot_t *snapshot[2] = { snapshot_create(), snapshot_create() };
+
+    if (snapshot[0] && snapshot[1])
+    {
+	cpu_set_trace_print(gb, false);
+	cpu_run_cached(gb, BENCH_EPISODE_INSTRUCTIONS);
+	snapshot_take(snapshot[0], gb);
+	snapshot_take(snapshot[1], gb);
+	for (size_t i = 0; i < count; i++)
+	{
+	    cpu_run_cached(gb, BENCH_EPISODE_INSTRUCTIONS);
+	    snapshot_restore(snapshot[i & 1], gb);
+	}
+    }
+    snapshot_free(snapshot[0]);
+    snapshot_free(snapshot[1]);
+}
+
+
+/* A rewind capture after every short run, as when capturing every frame */
+static void bench_rewind_capture(gb_t *gb, size_t count)
+{
+    rewind_t *rewind = rewind_create(REWIND_DEFAULT_BUDGET, REWIND_DEFAULT_INTERVAL);
+
+    if (!rewind)
+	return;
+    cpu_set_trace_print(gb, false);
+    for (size_t i = 0; i < count; i++)
+    {
+	cpu_run_cached(gb, BENCH_EPISODE_INSTRUCTIONS);
+	rewind_capture(rewind, gb);
+    }
+    rewind_free(rewind);
+}
+
+
+/* Branches off one state tree node: load it, run, capture the child and
+ * drop it again, as a tree search expanding the same node */
+static void bench_statetree_branch(gb_t *gb, size_t count)
+{
+    statetree_t *tree = statetree_create();
+    statetree_node_t *root;
+
+    if (!tree)
+	return;
+    cpu_set_trace_print(gb, false);
+    cpu_run_cached(gb, BENCH_EPISODE_INSTRUCTIONS);
+    root = statetree_capture(tree, gb);
+    for (size_t i = 0; root && i < count; i++)
+    {
+	statetree_load(root, gb);
+	cpu_run_cached(gb, BENCH_EPISODE_INSTRUCTIONS);
+	statetree_release(statetree_capture(tree, gb));
+    }
+    statetree_release(root);
+    statetree_free(tree);
+}
+
+
+/* Lines drawn from VRAM full of different tiles, with the window and 10
+ * sprites on every line, and a tile written before each */
+static void bench_ppu_line(gb_t *gb, size_t count)
+{
+    ppu_t *ppu = malloc(sizeof(ppu_t));
+    uint8_t *memory = calloc(1, 0x10000);
+    uint8_t window_line = 0;
+
+    (void)gb;
+    if (ppu && memory)
+    {
+	for (size_t i = 0x8000; i < 0xA000; i++)
+	    memory[i] = (uint8_t)(i * 7 + (i >> 8));
+	for (size_t i = 0; i < 40; i++)
+	{
+	    memory[0xFE00 + i * 4] = 16 + i / 10 * 8;
+	    memory[0xFE00 + i * 4 + 1] = 8 + i % 10 * 16;
+	    memory[0xFE00 + i * 4 + 2] = i;
+	    memory[0xFE00 + i * 4 + 3] = i << 4;
+	}
+	memory[0xFF47] = 0xE4;
+	memory[0xFF48] = 0xD2;
+	memory[0xFF49] = 0x1B;
+	memory[0xFF4B] = 87;
+	ppu_reset(ppu);
+	for (size_t i = 0; i < count; i++)
+	{
+	    uint8_t ly = i % PPU_HEIGHT;
+
+	    if (ly == 0)
+		window_line = 0;
+	    ppu_tile_written(ppu, 0x8000 + (i * 16 % 0x1800));
+	    ppu_render_line(ppu, memory, 0xF3, ly, &window_line);
+	}
+    }
+    free(memory);
+    free(ppu);
+}
+
+
+/* Register operands in the order a run of ALU/LD code would touch them.
+ * Not static, so the compiler can't fold the accesses away. */
+register_e bench_registers[] =
+{
+    REGISTER_A, REGISTER_B, REGISTER_C, REGISTER_HL, REGISTER_D, REGISTER_E,
+    REGISTER_BC, REGISTER_H, REGISTER_L, REGISTER_DE, REGISTER_SP, REGISTER_F,
+};
+#define BENCH_REGISTER_COUNT (sizeof(bench_registers) / sizeof(bench_registers[0]))
+
+registers_t bench_reg;
+static volatile uint16_t bench_sink;
+
+
+/* The per-operand switch the interpreter used before the register file
+ * became indexable */
+static uint16_t register_read_switch(const registers_t *reg, register_e r)
+{
+    switch(r)
+    {
+	case REGISTER_A: return reg->A;
+	case REGISTER_F: return reg->F;
+	case REGISTER_B: return reg->B;
+	case REGISTER_C: return reg->C;
+	case REGISTER_D: return reg->D;
+	case REGISTER_E: return reg->E;
+	case REGISTER_H: return reg->H;
+	case REGISTER_L: return reg->L;
+	case REGISTER_AF: return reg->AF;
+	case REGISTER_BC: return reg->BC;
+	case REGISTER_DE: return reg->DE;
+	case REGISTER_HL: return reg->HL;
+	case REGISTER_SP: return reg->SP;
+	default: return 0;
+    }
+}
+
+
+static void bench_register_switch(gb_t *gb, size_t count)
+{
+    uint16_t sum = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+	sum += register_read_switch(&bench_reg, bench_registers[i % BENCH_REGISTER_COUNT]);
+    }
+    bench_sink = sum;
+}
+
+
+static void bench_register_indexed(gb_t *gb, size_t count)
+{
+    uint16_t sum = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+	sum += register_read(&bench_reg, bench_registers[i % BENCH_REGISTER_COUNT]);
+    }
+    bench_sink = sum;
+}
+
+
+static void bench(const char *name, void (*run)(gb_t *, size_t), size_t count)
+{
+    gb_t *gb = gb_alloc();
+    double start, elapsed;
+
+    if (!gb)
+	return;
+    start = now_seconds();
+    run(gb, count);
+    fflush(stdout);
+    elapsed = now_seconds() - start;
+    gb_free(gb);
+
+    fprintf(stderr, "%-30s %10zu ops %8.3f s %12.0f ops/s\n",
+	    name, count, elapsed, count / elapsed);
+}
+
+
+int main(int argc, char **argv)
+{
+    size_t count = BENCH_DEFAULT_INSTRUCTIONS;
+
+    if (argc > 1)
+	sscanf(argv[1], "%zu", &count);
+
+    if (!freopen("/dev/null", "w", stdout))
+    {
+	perror("freopen");
+	return 1;
+    }
+
+    bench("cpu_fetch+cpu_execute", bench_step_loop, count);
+    bench("cpu_run", bench_cpu_run, count);
+    bench("cpu_run_cached", bench_cpu_run_cached, count);
+    bench("cpu_run_cached+dynarec", bench_dynarec, count);
+    bench("cpu_run (loop)", bench_loop_run, count);
+    bench("cpu_run_cached (loop)", bench_loop_cached, count);
+    bench("cpu_run_cached+dynarec (loop)", bench_loop_dynarec, count);
+    bench("16 lanes alone", bench_lanes_alone, count);
+    bench("16 lanes in lockstep", bench_lanes_lockstep, count);
+
+    bench("register read (switch)", bench_register_switch, count * 10);
+    bench("register read (indexed)", bench_register_indexed, count * 10);
+
+    bench("episode reset (dirty)", bench_snapshot_dirty, count / BENCH_EPISODE_INSTRUCTIONS);
+    bench("episode reset (full)", bench_snapshot_full, count / BENCH_EPISODE_INSTRUCTIONS);
+    bench("rewind capture", bench_rewind_capture, count / BENCH_EPISODE_INSTRUCTIONS);
+    bench("state tree branch", bench_statetree_branch, count / BENCH_EPISODE_INSTRUCTIONS);
+    bench("ppu line", bench_ppu_line, count / 10);
+
+    return 0;
+}
@@ -0,0 +1,308 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "gb.h"
+#include "lockstep.h"
+#include "opcode.h"
+
+/*
+ * Equivalence check of the faster execution paths against the interpreter.
+ *
+ * Each seed fills the address space with a random program made mostly of
+ * the register-only instructions the dynarec translates, in short loops
+ * closed by conditional branches, with loads, stores and jumps in between.
+ * The program runs through cpu_run() and again through the block cache,
+ * without and with the dynarec, and every run has to end with the same
+ * cpu_state_hash() and cpu_cycles(). Each seed runs a second time with
+ * interrupts on: the program is entered through code that starts the
+ * timer, overflowing every 256 cycles, and enables it and IME, and the
+ * handler at 0x50 changes D, so an interrupt taken at another instruction
+ * shows.
+ *
+ * Then groups of instances of each program, and of the built-in one, each
+ * with its own A, C and E, and every other lane with the dynarec, so they
+ * branch apart and meet again, run in lockstep and have to end where
+ * cpu_run_cycles() leaves a copy of each, both run in the same slices.
+ * The even seeds run with interrupts on.
+ *
+ * Exits with 1 at the first mismatch.
+ *
+ * usage: check [seeds] [instructions]
+ *
+ * The lanes of a lockstep group share the instruction budget, at 4 cycles
+ * an instruction.
+ */
+
+#define CHECK_DEFAULT_SEEDS        64
+#define CHECK_DEFAULT_INSTRUCTIONS 2000000
+#define CHECK_LANES                16
+#define CHECK_LOCKSTEP_SLICES      10
+#define CHECK_IRQ_HANDLER          0x0050
+#define CHECK_IRQ_ENTRY            0x0060
+
+/* Left out of the programs: EI, DI, RETI, HALT and STOP */
+static bool check_excluded(uint8_t value)
+{
+    return value == 0xFB || value == 0xF3 || value == 0xD9 || value == 0x76 ||
+	   value == 0x10 || opcode_get(value)->bytes == 0;
+}
+
+
+/* Entry with interrupts on, at CHECK_IRQ_ENTRY, and the timer's handler */
+static const uint8_t check_irq_entry[] =
+{
+    0x3E, 0xF0,         /* LD A, 0xF0 */
+    0xE0, 0x06,         /* LDH [TMA], A */
+    0x3E, 0x05,         /* LD A, 0x05, TIMA every 16 cycles */
+    0xE0, 0x07,         /* LDH [TAC], A */
+    0x3E, 0x04,         /* LD A, 0x04, the timer */
+    0xE0, 0xFF,         /* LDH [IE], A */
+    0xFB,               /* EI */
+    0xC3, 0x00, 0x01,   /* JP 0x0100 */
+};
+
+static const uint8_t check_irq_handler[] =
+{
+    0x14,               /* INC D */
+    0xD9,               /* RETI */
+};
+
+
+/* Register-only instructions, which are what the dynarec translates and
+ * lockstep runs on all its lanes at once */
+static bool check_register_only(uint8_t value)
+{
+    if (value >= 0x40 && value < 0x80)      /* LD r, r */
+	return (value & 7) != 6 && (value & 0x38) != 0x30;
+    if (value >= 0x80 && value < 0xC0)      /* ALU A, r */
+	return (value & 7) != 6;
+    switch(value & 0xC7)
+    {
+	case 0x04: case 0x05: case 0x06: /* INC r, DEC r, LD r, n */
+	    return (value & 0x38) != 0x30;
+	case 0x03:                       /* INC rr, DEC rr */
+	case 0xC6:                       /* ALU A, n */
+	    return true;
+	default:
+	    return value == 0x2F || value == 0x37 || value == 0x3F; /* CPL, SCF, CCF */
+    }
+}
+
+
+static void check_program(gb_t *gb, unsigned seed, bool interrupts)
+{
+    uint8_t *memory = gb->RAM;
+    uint32_t address = interrupts ? 0x0100 : 0;
+
+    srand(seed);
+    while (address < 0x7FF0)
+    {
+	uint32_t loop = address;
+	int length = 2 + rand() % 12;
+
+	for (int i = 0; i < length && address < 0x7FF0; i++)
+	{
+	    uint8_t value;
+
+	    if (rand() % 8 == 0)
+	    {
+		/* PUSH AF, POP BC, so what the run did to F shows */
+		memory[address++] = 0xF5;
+		memory[address++] = 0xC1;
+		continue;
+	    }
+	    do
+	    {
+		value = rand();
+	    } while (check_excluded(value) || (rand() % 4 && !check_register_only(value)));
+
+	    memory[address] = value;
+	    for (int j = 1; j < opcode_get(value)->bytes; j++)
+		memory[address + j] = rand();
+	    address += opcode_get(value)->bytes;
+	}
+	/* JR NZ, JR Z, JR NC or JR C back to the start of the run */
+	memory[address] = 0x20 + (rand() % 4) * 8;
+	memory[address + 1] = (uint8_t)(loop - (address + 2));
+	address += 2;
+    }
+    gb->reg.PC = 0x0100;
+    gb->reg.SP = 0xDFF0;
+    if (interrupts)
+    {
+	memcpy(&memory[CHECK_IRQ_HANDLER], check_irq_handler, sizeof(check_irq_handler));
+	memcpy(&memory[CHECK_IRQ_ENTRY], check_irq_entry, sizeof(check_irq_entry));
+	gb->reg.PC = CHECK_IRQ_ENTRY;
+    }
+}
+
+
+/* Run `count` instructions of program `seed` and return the final state */
+static void check_run(unsigned seed, bool interrupts, size_t count, int mode, uint64_t *hash,
+		      uint64_t *cycles)
+{
+    gb_t *gb = gb_alloc();
+
+    if (!gb)
+    {
+	fprintf(stderr, "out of memory\n");
+	exit(1);
+    }
+    cpu_set_trace_print(gb, false);
+    check_program(gb, seed, interrupts);
+    if (mode == 0)
+	cpu_run(gb, count);
+    else
+    {
+	if (mode == 2 && !cpu_set_dynarec(gb, true))
+	    fprintf(stderr, "no dynarec on this host, checking the block cache again\n");
+	cpu_run_cached(gb, count);
+    }
+    *hash = cpu_state_hash(gb);
+    *cycles = cpu_cycles(gb);
+    gb_free(gb);
+}
+
+
+/* ======= CHECKS ======= */
+
+static bool check_interpreter(unsigned seeds, size_t count, bool interrupts)
+{
+    static const char *modes[] = { "cpu_run", "cpu_run_cached", "cpu_run_cached+dynarec" };
+    const char *name = interrupts ? "interrupts" : "interpreter";
+
+    for (unsigned seed = 1; seed <= seeds; seed++)
+    {
+	uint64_t hash[3], cycles[3];
+
+	for (int mode = 0; mode < 3; mode++)
+	{
+	    check_run(seed, interrupts, count, mode, &hash[mode], &cycles[mode]);
+	    if (hash[mode] != hash[0] || cycles[mode] != cycles[0])
+	    {
+		fprintf(stderr, "%s seed %u: %s ends at %016llx after %llu cycles, "
+			"%s at %016llx after %llu\n", name, seed,
+			modes[mode], (unsigned long long)hash[mode],
+			(unsigned long long)cycles[mode], modes[0],
+			(unsigned long long)hash[0], (unsigned long long)cycles[0]);
+		return false;
+	    }
+	}
+    }
+    fprintf(stderr, "%-24s %u programs of %zu instructions ok\n", name, seeds, count);
+    return true;
+}
+
+
+/* Program `seed`, or the built-in one for 0, on every instance of `lanes`
+ * and `alone`, lane i starting from its own registers. Even seeds run
+ * with interrupts on. */
+static bool check_lanes(unsigned seed, gb_t **lanes, gb_t **alone)
+{
+    for (int i = 0; i < CHECK_LANES; i++)
+    {
+	gb_t *pair[2] = { lanes[i] = gb_alloc(), alone[i] = gb_alloc() };
+
+	for (int j = 0; j < 2; j++)
+	{
+	    if (!pair[j])
+		return false;
+	    cpu_set_trace_print(pair[j], false);
+	    if (seed)
+		check_program(pair[j], seed, seed % 2 == 0);
+	    if (i % 2)
+		cpu_set_dynarec(pair[j], true);
+	    pair[j]->reg.A = i * 17;
+	    pair[j]->reg.C = i * 5;
+	    pair[j]->reg.E = i & 3;
+	}
+    }
+    return true;
+}
+
+
+static bool check_lockstep(unsigned seeds, size_t count)
+{
+    uint64_t cycles = count * 4 / CHECK_LANES / CHECK_LOCKSTEP_SLICES;
+    lockstep_stats_t total = { 0 };
+
+    for (unsigned seed = 0; seed <= seeds; seed++)
+    {
+	gb_t *lanes[CHECK_LANES] = { NULL };
+	gb_t *alone[CHECK_LANES] = { NULL };
+	lockstep_t *lockstep = NULL;
+	lockstep_stats_t stats;
+	bool same = true;
+
+	if (!check_lanes(seed, lanes, alone) ||
+	    !(lockstep = lockstep_create(lanes, CHECK_LANES)))
+	{
+	    fprintf(stderr, "out of memory\n");
+	    exit(1);
+	}
+	/* in slices, so the lanes are stopped and started again part way */
+	for (int slice = 0; slice < CHECK_LOCKSTEP_SLICES; slice++)
+	{
+	    lockstep_run_cycles(lockstep, cycles);
+	    for (int i = 0; i < CHECK_LANES; i++)
+	    {
+		cpu_run_cycles(alone[i], cycles);
+	    }
+	}
+	for (int i = 0; i < CHECK_LANES && same; i++)
+	{
+	    if (cpu_state_hash(lanes[i]) != cpu_state_hash(alone[i]) ||
+		cpu_cycles(lanes[i]) != cpu_cycles(alone[i]))
+	    {
+		fprintf(stderr, "seed %u: lane %d ends at %016llx after %llu cycles in lockstep, "
+			"at %016llx after %llu alone\n", seed, i,
+			(unsigned long long)cpu_state_hash(lanes[i]),
+			(unsigned long long)cpu_cycles(lanes[i]),
+			(unsigned long long)cpu_state_hash(alone[i]),
+			(unsigned long long)cpu_cycles(alone[i]));
+		same = false;
+	    }
+	}
+	lockstep_stats(lockstep, &stats);
+	total.vector_instructions += stats.vector_instructions;
+	total.vector_lane_instructions += stats.vector_lane_instructions;
+	lockstep_free(lockstep);
+	for (int i = 0; i < CHECK_LANES; i++)
+	{
+	    gb_free(lanes[i]);
+	    gb_free(alone[i]);
+	}
+	if (!same)
+	    return false;
+    }
+    fprintf(stderr, "%-24s %u programs of %llu cycles on %d lanes ok, %llu instructions "
+	    "decoded once for %llu lane instructions\n", "lockstep", seeds + 1,
+	    (unsigned long long)cycles * CHECK_LOCKSTEP_SLICES, CHECK_LANES,
+	    (unsigned long long)total.vector_instructions,
+	    (unsigned long long)total.vector_lane_instructions);
+    return true;
+}
+
+
+int main(int argc, char **argv)
+{
+    unsigned seeds = CHECK_DEFAULT_SEEDS;
+    size_t count = CHECK_DEFAULT_INSTRUCTIONS;
+
+    if (argc > 1)
+	sscanf(argv[1], "%u", &seeds);
+    if (argc > 2)
+	sscanf(argv[2], "%zu", &count);
+
+    if (!check_interpreter(seeds, count, false))
+	return 1;
+    if (!check_interpreter(seeds, count, true))
+	return 1;
+    if (!check_lockstep(seeds, count))
+	return 1;
+
+    return 0;
+}
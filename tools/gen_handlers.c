@@ -0,0 +1,668 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "opcode.h"
+
+/*
+ * Build-time generator for the specialised opcode handlers.
+ *
+ * Walks the descriptive opcodes[] table and emits one handler per opcode
+ * with the operand access already resolved, plus the dispatch table that
+ * cpu.c indexes with the fetched opcode, the per-opcode length, cycle and
+ * block-terminator tables used by the predecoder, and an OPCODE_LIST
+ * X-macro for the threaded interpreter loop. cb_opcodes[] gets the same
+ * treatment for the second level behind the 0xCB prefix, with the bit
+ * index and register of each instruction baked into its handler. The
+ * output is #included by cpu.c so the handlers can touch the cpu state
+ * directly.
+ *
+ * Handlers take the operand bytes that follow the opcode already
+ * assembled into `imm` (little-endian), so they never read at PC. They
+ * don't trace; cpu.c prints the disassembly around the call when built
+ * with tracing enabled.
+ *
+ * usage: gen_handlers > cpu_handlers.inc
+ */
+
+typedef struct {
+    char fetch[64];  /* statement naming the immediate operand, may be empty */
+    char value[64];  /* expression reading the operand */
+    char lvalue[64]; /* register written by the operand, empty if none */
+    char addr[64];   /* address written by the operand, empty if none */
+    bool wide;       /* operand is 16 bits wide */
+} operand_code_t;
+
+
+static int operand_code(operand_t *operand, operand_code_t *code)
+{
+    const char *reg = register_to_string(operand->reg);
+
+    memset(code, 0, sizeof(*code));
+    switch(operand->type)
+    {
+	case OPERAND_TYPE_REGISTER_8BIT:
+	{
+	    if (operand->immediate)
+	    {
+		snprintf(code->value, sizeof(code->value),
+			"gb->reg.r8[REG8_%s]", reg);
+		strcpy(code->lvalue, code->value);
+	    }
+	    else
+	    {
+		/* [C] is the HRAM offset form used by LDH */
+		snprintf(code->addr, sizeof(code->addr),
+			"0xFF00 + gb->reg.r8[REG8_%s]", reg);
+	    }
+	} break;
+
+	case OPERAND_TYPE_REGISTER_16BIT:
+	{
+	    if (operand->immediate)
+	    {
+		snprintf(code->value, sizeof(code->value),
+			"gb->reg.r16[REG16_%s]", reg);
+		strcpy(code->lvalue, code->value);
+		code->wide = true;
+	    }
+	    else
+	    {
+		snprintf(code->addr, sizeof(code->addr),
+			"gb->reg.r16[REG16_%s]", reg);
+	    }
+	} break;
+
+	case OPERAND_TYPE_N8:
+	{
+	    strcpy(code->fetch, "uint8_t n8 = (uint8_t)imm;");
+	    strcpy(code->value, "n8");
+	} break;
+
+	case OPERAND_TYPE_E8:
+	{
+	    strcpy(code->fetch, "int8_t e8 = (int8_t)imm;");
+	    strcpy(code->value, "e8");
+	} break;
+
+	case OPERAND_TYPE_A8:
+	{
+	    strcpy(code->fetch, "uint8_t a8 = (uint8_t)imm;");
+	    if (operand->immediate)
+	    {
+		strcpy(code->value, "a8");
+	    }
+	    else
+	    {
+		strcpy(code->addr, "0xFF00 + a8");
+	    }
+	} break;
+
+	case OPERAND_TYPE_N16:
+	case OPERAND_TYPE_A16:
+	{
+	    strcpy(code->fetch, "uint16_t n16 = imm;");
+	    if (operand->immediate)
+	    {
+		strcpy(code->value, "n16");
+		code->wide = true;
+	    }
+	    else
+	    {
+		strcpy(code->addr, "n16");
+	    }
+	} break;
+
+	default:
+	{
+	    return -1;
+	}
+    }
+
+    if (code->addr[0])
+	snprintf(code->value, sizeof(code->value), "bus_read(gb, %s)", code->addr);
+    return 0;
+}
+
+
+static bool operand_writable(operand_code_t *code)
+{
+    return code->lvalue[0] || code->addr[0];
+}
+
+
+static void emit_store(operand_code_t *dst, const char *value)
+{
+    if (dst->addr[0])
+	printf("    bus_write(gb, %s, %s);\n", dst->addr, value);
+    else
+	printf("    %s = %s;\n", dst->lvalue, value);
+}
+
+
+static void emit_fetch(operand_code_t *code)
+{
+    if (code && code->fetch[0])
+	printf("    %s\n", code->fetch);
+}
+
+
+static void emit_unsupported()
+{
+    printf("    cpu_unsupported(gb);\n");
+}
+
+
+/* LD HL, SP + e8 */
+static void emit_ld_hl_sp()
+{
+    printf("    int8_t e8 = (int8_t)imm;\n");
+    printf("    gb->reg.r16[REG16_HL] = alu_add_sp(gb, e8);\n");
+}
+
+
+static void emit_ld(opcode_t *opcode)
+{
+    operand_code_t dst, src;
+
+    if (opcode->op_right.type == OPERAND_TYPE_E8)
+    {
+	emit_ld_hl_sp();
+	return;
+    }
+
+    if (operand_code(&opcode->op_left, &dst) < 0 ||
+	operand_code(&opcode->op_right, &src) < 0 ||
+	!operand_writable(&dst))
+    {
+	emit_unsupported();
+	return;
+    }
+
+    emit_fetch(&dst);
+    emit_fetch(&src);
+
+    if (src.wide && !dst.wide)
+    {
+	/* 16-bit register stored through a pointer, e.g. LD [a16], SP */
+	printf("    bus_write(gb, %s, (uint8_t)%s);\n", dst.addr, src.value);
+	printf("    bus_write(gb, (uint16_t)(%s + 1), (uint8_t)(%s >> 8));\n",
+		dst.addr, src.value);
+    }
+    else
+    {
+	emit_store(&dst, src.value);
+    }
+}
+
+
+/* Flag test for a conditional instruction, NULL if unconditional */
+static const char *condition(instruction_e inst)
+{
+    switch(inst)
+    {
+	case INST_JR_Z: case INST_JP_Z: case INST_CALL_Z: case INST_RET_Z:
+	    return "flag_z(gb)";
+	case INST_JR_NZ: case INST_JP_NZ: case INST_CALL_NZ: case INST_RET_NZ:
+	    return "!flag_z(gb)";
+	case INST_JR_C: case INST_JP_C: case INST_CALL_C: case INST_RET_C:
+	    return "flag_c(gb)";
+	case INST_JR_NC: case INST_JP_NC: case INST_CALL_NC: case INST_RET_NC:
+	    return "!flag_c(gb)";
+	default:
+	    return NULL;
+    }
+}
+
+
+static void emit_ldi_ldd(opcode_t *opcode, const char *step)
+{
+    emit_ld(opcode);
+    printf("    gb->reg.r16[REG16_HL]%s;\n", step);
+}
+
+
+/* 8-bit arithmetic and logic on A, `helper` is the alu_* function */
+static void emit_alu(opcode_t *opcode, const char *helper)
+{
+    operand_code_t dst, src;
+
+    if (operand_code(&opcode->op_left, &dst) < 0 ||
+	operand_code(&opcode->op_right, &src) < 0 ||
+	opcode->op_left.reg != REGISTER_A)
+    {
+	emit_unsupported();
+	return;
+    }
+
+    emit_fetch(&src);
+    printf("    %s(gb, %s);\n", helper, src.value);
+}
+
+
+static void emit_add(opcode_t *opcode)
+{
+    operand_code_t dst, src;
+
+    if (opcode->op_left.type == OPERAND_TYPE_REGISTER_8BIT)
+    {
+	emit_alu(opcode, "alu_add");
+	return;
+    }
+
+    if (operand_code(&opcode->op_left, &dst) < 0 ||
+	operand_code(&opcode->op_right, &src) < 0 ||
+	opcode->op_left.type != OPERAND_TYPE_REGISTER_16BIT)
+    {
+	emit_unsupported();
+	return;
+    }
+
+    emit_fetch(&src);
+    if (opcode->op_left.reg == REGISTER_SP)
+	printf("    gb->reg.r16[REG16_SP] = alu_add_sp(gb, %s);\n", src.value);
+    else
+	printf("    %s = alu_add_hl(gb, %s, %s);\n", dst.lvalue, dst.value, src.value);
+}
+
+
+/* INC/DEC, `helper` is alu_inc/alu_dec and `step` the 16-bit form */
+static void emit_inc_dec(opcode_t *opcode, const char *helper, const char *step)
+{
+    operand_code_t dst;
+    char value[80];
+
+    if (operand_code(&opcode->op_left, &dst) < 0 || !operand_writable(&dst))
+    {
+	emit_unsupported();
+	return;
+    }
+
+    if (dst.wide)
+    {
+	/* 16-bit INC/DEC leave the flags alone */
+	printf("    %s%s;\n", dst.lvalue, step);
+	return;
+    }
+    snprintf(value, sizeof(value), "%s(gb, %s)", helper, dst.value);
+    emit_store(&dst, value);
+}
+
+
+/* JR/JP/CALL with an optional condition; `taken` is the extra cycles a
+ * taken conditional branch costs over opcode_t.cycles */
+static void emit_jump(opcode_t *opcode, bool call, int taken)
+{
+    const char *cond = condition(opcode->inst);
+    operand_code_t target;
+
+    if (operand_code(&opcode->op_left, &target) < 0)
+    {
+	emit_unsupported();
+	return;
+    }
+
+    emit_fetch(&target);
+
+    if (cond)
+	printf("    if (%s)\n    {\n\tgb->cycles += %d;\n", cond, taken);
+    if (call)
+	printf("%sstack_push(gb, gb->reg.r16[REG16_PC]);\n", cond ? "\t" : "    ");
+    if (opcode->op_left.type == OPERAND_TYPE_E8)
+	printf("%sgb->reg.r16[REG16_PC] += %s;\n", cond ? "\t" : "    ", target.value);
+    else
+	printf("%sgb->reg.r16[REG16_PC] = %s;\n", cond ? "\t" : "    ", target.value);
+    if (cond)
+	printf("    }\n");
+}
+
+
+static void emit_ret(opcode_t *opcode)
+{
+    const char *cond = condition(opcode->inst);
+
+    if (cond)
+    {
+	printf("    if (%s)\n    {\n", cond);
+	printf("\tgb->cycles += 12;\n");
+	printf("\tgb->reg.r16[REG16_PC] = stack_pop(gb);\n");
+	printf("    }\n");
+	return;
+    }
+    printf("    gb->reg.r16[REG16_PC] = stack_pop(gb);\n");
+    if (opcode->inst == INST_RETI)
+	printf("    cpu_set_ime(gb, true);\n");
+}
+
+
+static void emit_rst(uint8_t value)
+{
+    printf("    stack_push(gb, gb->reg.r16[REG16_PC]);\n");
+    printf("    gb->reg.r16[REG16_PC] = 0x%04X;\n", value & 0x38);
+}
+
+
+static void emit_push_pop(opcode_t *opcode, bool push)
+{
+    operand_code_t reg;
+
+    if (operand_code(&opcode->op_left, &reg) < 0 || !reg.wide)
+    {
+	emit_unsupported();
+	return;
+    }
+
+    if (opcode->op_left.reg == REGISTER_AF)
+    {
+	/* F goes through the lazy flag state */
+	if (push)
+	{
+	    printf("    stack_push(gb, (uint16_t)gb->reg.r8[REG8_A] << 8 | flags_get(gb));\n");
+	}
+	else
+	{
+	    printf("    uint16_t af = stack_pop(gb);\n");
+	    printf("    gb->reg.r8[REG8_A] = (uint8_t)(af >> 8);\n");
+	    printf("    flags_set(gb, (uint8_t)af);\n");
+	}
+	return;
+    }
+
+    if (push)
+	printf("    stack_push(gb, %s);\n", reg.value);
+    else
+	printf("    %s = stack_pop(gb);\n", reg.lvalue);
+}
+
+
+/* CB prefixed rotate or shift, `helper` is the alu_* function */
+static void emit_cb_shift(opcode_t *opcode, const char *helper)
+{
+    operand_code_t dst;
+    char value[80];
+
+    if (operand_code(&opcode->op_left, &dst) < 0 || !operand_writable(&dst))
+    {
+	emit_unsupported();
+	return;
+    }
+
+    snprintf(value, sizeof(value), "%s(gb, %s)", helper, dst.value);
+    emit_store(&dst, value);
+}
+
+
+/* BIT/RES/SET, the bit index comes from the table entry */
+static void emit_cb_bit(opcode_t *opcode)
+{
+    uint8_t mask = 1 << opcode->op_left.value;
+    operand_code_t dst;
+    char value[96];
+
+    if (opcode->op_left.type != OPERAND_TYPE_U3 ||
+	operand_code(&opcode->op_right, &dst) < 0 || !operand_writable(&dst))
+    {
+	emit_unsupported();
+	return;
+    }
+
+    switch(opcode->inst)
+    {
+	case INST_BIT:
+	{
+	    printf("    alu_bit(gb, %d, %s);\n", opcode->op_left.value, dst.value);
+	    return;
+	}
+	case INST_RES:
+	{
+	    snprintf(value, sizeof(value), "%s & 0x%02X", dst.value, (uint8_t)~mask);
+	} break;
+	default:
+	{
+	    snprintf(value, sizeof(value), "%s | 0x%02X", dst.value, mask);
+	} break;
+    }
+    emit_store(&dst, value);
+}
+
+
+/* Instruction with no operands implemented by a single helper call */
+static void emit_call(const char *statement)
+{
+    printf("    %s\n", statement);
+}
+
+
+/* Total length in bytes, opcode included. Undefined opcodes count as one. */
+static uint8_t opcode_length(uint8_t value)
+{
+    opcode_t *opcode = opcode_get(value);
+    return opcode->bytes ? opcode->bytes : 1;
+}
+
+
+/* Instructions after which straight-line decoding has to stop */
+static bool opcode_ends_block(uint8_t value)
+{
+    switch(opcode_get(value)->inst)
+    {
+	case INST_JR: case INST_JR_Z: case INST_JR_NZ: case INST_JR_C:
+	case INST_JR_NC: case INST_JP: case INST_JP_Z: case INST_JP_NZ:
+	case INST_JP_C: case INST_JP_NC: case INST_CALL: case INST_CALL_Z:
+	case INST_CALL_NZ: case INST_CALL_NC: case INST_CALL_C: case INST_RET:
+	case INST_RETI: case INST_RET_Z: case INST_RET_NZ: case INST_RET_NC:
+	case INST_RET_C: case INST_RST:
+	case INST_HALT: case INST_STOP:
+	    return true;
+	default:
+	    return false;
+    }
+}
+
+
+static void emit_handler(uint8_t value)
+{
+    opcode_t *opcode = opcode_get(value);
+
+    printf("static inline void op_%02X(gb_t *gb, uint16_t imm)\n{\n", value);
+    switch(opcode->inst)
+    {
+	case INST_NOP:
+	{
+	    /* nothing to do */
+	} break;
+	case INST_LD:
+	case INST_LDH:
+	{
+	    emit_ld(opcode);
+	} break;
+	case INST_LDI:
+	{
+	    emit_ldi_ldd(opcode, "++");
+	} break;
+	case INST_LDD:
+	{
+	    emit_ldi_ldd(opcode, "--");
+	} break;
+	case INST_ADD:
+	{
+	    emit_add(opcode);
+	} break;
+	case INST_ADC: emit_alu(opcode, "alu_adc"); break;
+	case INST_SUB: emit_alu(opcode, "alu_sub"); break;
+	case INST_SBC: emit_alu(opcode, "alu_sbc"); break;
+	case INST_AND: emit_alu(opcode, "alu_and"); break;
+	case INST_XOR: emit_alu(opcode, "alu_xor"); break;
+	case INST_OR:  emit_alu(opcode, "alu_or"); break;
+	case INST_CP:  emit_alu(opcode, "alu_cp"); break;
+	case INST_INC: emit_inc_dec(opcode, "alu_inc", "++"); break;
+	case INST_DEC: emit_inc_dec(opcode, "alu_dec", "--"); break;
+	case INST_JR:
+	case INST_JR_Z:
+	case INST_JR_NZ:
+	case INST_JR_C:
+	case INST_JR_NC:
+	case INST_JP:
+	case INST_JP_Z:
+	case INST_JP_NZ:
+	case INST_JP_C:
+	case INST_JP_NC:
+	{
+	    emit_jump(opcode, false, 4);
+	} break;
+	case INST_CALL:
+	case INST_CALL_Z:
+	case INST_CALL_NZ:
+	case INST_CALL_C:
+	case INST_CALL_NC:
+	{
+	    emit_jump(opcode, true, 12);
+	} break;
+	case INST_RET:
+	case INST_RETI:
+	case INST_RET_Z:
+	case INST_RET_NZ:
+	case INST_RET_C:
+	case INST_RET_NC:
+	{
+	    emit_ret(opcode);
+	} break;
+	case INST_RST:  emit_rst(value); break;
+	case INST_PUSH: emit_push_pop(opcode, true); break;
+	case INST_POP:  emit_push_pop(opcode, false); break;
+	case INST_RLCA: emit_call("alu_rlca(gb);"); break;
+	case INST_RRCA: emit_call("alu_rrca(gb);"); break;
+	case INST_RLA:  emit_call("alu_rla(gb);"); break;
+	case INST_RRA:  emit_call("alu_rra(gb);"); break;
+	case INST_DAA:  emit_call("alu_daa(gb);"); break;
+	case INST_CPL:  emit_call("alu_cpl(gb);"); break;
+	case INST_SCF:  emit_call("alu_scf(gb);"); break;
+	case INST_CCF:  emit_call("alu_ccf(gb);"); break;
+	case INST_DI:   emit_call("gb->ime = false;"); break;
+	case INST_EI:   emit_call("cpu_set_ime(gb, true);"); break;
+	case INST_HALT: emit_call("cpu_halt(gb);"); break;
+	case INST_PREFIX:
+	{
+	    /* the prefix's own cycles are already in opcode_cycles[0xCB] */
+	    printf("    gb->cycles += cb_cycles[imm];\n");
+	    printf("    cb_handlers[imm](gb, imm);\n");
+	} break;
+	default:
+	{
+	    emit_unsupported();
+	}
+    }
+    printf("}\n\n");
+}
+
+
+static void emit_cb_handler(uint8_t value)
+{
+    opcode_t *opcode = opcode_cb_get(value);
+
+    printf("static inline void cb_%02X(gb_t *gb, uint16_t imm)\n{\n", value);
+    switch(opcode->inst)
+    {
+	case INST_RLC:  emit_cb_shift(opcode, "alu_rlc"); break;
+	case INST_RRC:  emit_cb_shift(opcode, "alu_rrc"); break;
+	case INST_RL:   emit_cb_shift(opcode, "alu_rl"); break;
+	case INST_RR:   emit_cb_shift(opcode, "alu_rr"); break;
+	case INST_SLA:  emit_cb_shift(opcode, "alu_sla"); break;
+	case INST_SRA:  emit_cb_shift(opcode, "alu_sra"); break;
+	case INST_SWAP: emit_cb_shift(opcode, "alu_swap"); break;
+	case INST_SRL:  emit_cb_shift(opcode, "alu_srl"); break;
+	case INST_BIT:
+	case INST_RES:
+	case INST_SET:
+	{
+	    emit_cb_bit(opcode);
+	} break;
+	default:
+	{
+	    emit_unsupported();
+	}
+    }
+    printf("}\n\n");
+}
+
+
+int main(int argc, char **argv)
+{
+    printf("/* Generated by tools/gen_handlers.c from opcodes[] and cb_opcodes[]"
+	   " in opcode.c. Do not edit. */\n\n");
+
+    for (int i = 0; i < OPCODE_COUNT; i++)
+    {
+	emit_cb_handler((uint8_t)i);
+    }
+
+    printf("static const opcode_handler_t cb_handlers[OPCODE_COUNT] =\n{\n");
+    for (int i = 0; i < OPCODE_COUNT; i++)
+    {
+	printf("    [0x%02X] = cb_%02X,\n", i, i);
+    }
+    printf("};\n\n");
+
+    /* on top of opcode_cycles[0xCB], which covers the prefix */
+    printf("static const uint8_t cb_cycles[OPCODE_COUNT] =\n{\n");
+    for (int i = 0; i < OPCODE_COUNT; i++)
+    {
+	printf("    [0x%02X] = %d,\n", i,
+	       opcode_cb_get((uint8_t)i)->cycles - opcode_get(0xCB)->cycles);
+    }
+    printf("};\n\n");
+
+    for (int i = 0; i < OPCODE_COUNT; i++)
+    {
+	emit_handler((uint8_t)i);
+    }
+
+    printf("static const opcode_handler_t opcode_handlers[OPCODE_COUNT] =\n{\n");
+    for (int i = 0; i < OPCODE_COUNT; i++)
+    {
+	printf("    [0x%02X] = op_%02X,\n", i, i);
+    }
+    printf("};\n\n");
+
+    printf("static const uint8_t opcode_lengths[OPCODE_COUNT] =\n{\n");
+    for (int i = 0; i < OPCODE_COUNT; i++)
+    {
+	printf("    [0x%02X] = %d,\n", i, opcode_length((uint8_t)i));
+    }
+    printf("};\n\n");
+
+    printf("static const uint8_t opcode_cycles[OPCODE_COUNT] =\n{\n");
+    for (int i = 0; i < OPCODE_COUNT; i++)
+    {
+	printf("    [0x%02X] = %d,\n", i, opcode_get((uint8_t)i)->cycles);
+    }
+    printf("};\n\n");
+
+    printf("static const bool opcode_ends_block[OPCODE_COUNT] =\n{\n");
+    for (int i = 0; i < OPCODE_COUNT; i++)
+    {
+	if (opcode_ends_block((uint8_t)i))
+	    printf("    [0x%02X] = true,\n", i);
+    }
+    printf("};\n\n");
+
+    /* X-macro over every opcode and its length, used to build the
+     * threaded dispatch loop. The 0xCB prefix is left out, the loop
+     * dispatches it a second time through CB_OPCODE_LIST. */
+    printf("#define OPCODE_LIST(X) \\\n");
+    for (int i = 0; i < OPCODE_COUNT; i++)
+    {
+	if (opcode_get((uint8_t)i)->inst == INST_PREFIX)
+	    continue;
+	printf("    X(%02X, %d)%s\n", i, opcode_length((uint8_t)i),
+		i == OPCODE_COUNT - 1 ? "" : " \\");
+    }
+    printf("\n");
+
+    printf("#define CB_OPCODE_LIST(X) \\\n");
+    for (int i = 0; i < OPCODE_COUNT; i++)
+    {
+	printf("    X(%02X)%s\n", i, i == OPCODE_COUNT - 1 ? "" : " \\");
+    }
+
+    return 0;
+}
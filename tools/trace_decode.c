@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "trace.h"
+
+/*
+ * Offline decoder for binary traces recorded with hgbemu --trace.
+ *
+ * Prints the records in the text format of the TRACE_INSTRUCTION level,
+ * or of TRACE_FULL with -r. Records dropped on overflow are reported on
+ * stderr.
+ *
+ * usage: trace_decode [-r] FILE
+ */
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "usage: %s [-r] FILE\n", program);
+    fprintf(stderr, "  -r  include the registers and cycle count\n");
+}
+
+
+int main(int argc, char **argv)
+{
+    trace_file_header_t header;
+    trace_record_t record;
+    const char *path = NULL;
+    bool registers = false;
+    char line[128];
+    FILE *file;
+
+    for (int i = 1; i < argc; i++)
+    {
+	if (strcmp(argv[i], "-r") == 0)
+	    registers = true;
+	else if (!path)
+	    path = argv[i];
+	else
+	{
+	    usage(argv[0]);
+	    return 1;
+	}
+    }
+    if (!path)
+    {
+	usage(argv[0]);
+	return 1;
+    }
+
+    file = fopen(path, "rb");
+    if (!file)
+    {
+	perror(path);
+	return 1;
+    }
+
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+	memcmp(header.magic, TRACE_FILE_MAGIC, sizeof(TRACE_FILE_MAGIC)) != 0 ||
+	header.version != TRACE_FILE_VERSION ||
+	header.record_size != sizeof(trace_record_t))
+    {
+	fprintf(stderr, "%s: not a version %d trace file\n", path, TRACE_FILE_VERSION);
+	fclose(file);
+	return 1;
+    }
+
+    while (fread(&record, sizeof(record), 1, file) == 1)
+    {
+	trace_format(line, sizeof(line), &record, registers);
+	printf("%s\n", line);
+    }
+
+    if (header.dropped)
+	fprintf(stderr, "%s: %llu records were dropped while recording\n",
+		path, (unsigned long long)header.dropped);
+
+    fclose(file);
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "disasm.h"
+#include "trace.h"
+
+/*
+ * Binary execution trace.
+ *
+ * The emulator thread is the only producer and the writer thread the only
+ * consumer of a power-of-two ring of trace_record_t, so head and tail are
+ * plain atomics without locks: the producer publishes a record with a
+ * release store of head and the consumer frees slots with a release store
+ * of tail. The writer drains whatever is queued in one or two fwrite()s
+ * and naps briefly when the ring is empty. The emulator only waits on the
+ * disk when the ring is full and the overflow policy is to block.
+ */
+#define TRACE_WRITER_IDLE_NS 100000
+
+struct trace_ring_s {
+    _Alignas(64) atomic_size_t head; /* next slot the producer fills */
+    _Alignas(64) atomic_size_t tail; /* next slot the writer drains */
+    _Alignas(64) size_t tail_cache;  /* producer's last view of tail */
+    atomic_bool stop;
+    uint64_t dropped;
+    trace_overflow_e overflow;
+    size_t mask;
+    trace_record_t *records;
+    FILE *file;
+    pthread_t writer;
+};
+
+
+/* ======= PRIVATE FUNCTIONS ======= */
+static void writer_idle()
+{
+    struct timespec ts = { 0, TRACE_WRITER_IDLE_NS };
+    nanosleep(&ts, NULL);
+}
+
+
+static void *writer_main(void *arg)
+{
+    trace_ring_t *ring = arg;
+    size_t capacity = ring->mask + 1;
+
+    for (;;)
+    {
+	/* read stop before head, so a stop seen here covers every record
+	 * the producer published before setting it */
+	bool stopping = atomic_load_explicit(&ring->stop, memory_order_acquire);
+	size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	size_t start, count;
+
+	if (head == tail)
+	{
+	    if (stopping)
+		break;
+	    writer_idle();
+	    continue;
+	}
+
+	/* up to the end of the buffer, the rest goes on the next pass */
+	start = tail & ring->mask;
+	count = head - tail;
+	if (start + count > capacity)
+	    count = capacity - start;
+
+	fwrite(&ring->records[start], sizeof(trace_record_t), count, ring->file);
+	atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+    }
+
+    return NULL;
+}
+
+
+/* ======= PUBLIC FUNCTIONS ======= */
+
+/*
+ * Start recording to `path` through a ring of at least `records` entries.
+ * Returns NULL if the file or the writer thread can't be set up.
+ */
+trace_ring_t *trace_open(const char *path, size_t records, trace_overflow_e overflow)
+{
+    trace_file_header_t header = { .magic = TRACE_FILE_MAGIC };
+    trace_ring_t *ring;
+    size_t capacity = 1;
+
+    while (capacity < records)
+	capacity <<= 1;
+
+    ring = aligned_alloc(_Alignof(trace_ring_t), sizeof(trace_ring_t));
+    if (!ring)
+	return NULL;
+    ring->file = fopen(path, "wb");
+    if (!ring->file)
+    {
+	free(ring);
+	return NULL;
+    }
+
+    header.version = TRACE_FILE_VERSION;
+    header.record_size = sizeof(trace_record_t);
+    ring->records = calloc(capacity, sizeof(trace_record_t));
+    if (!ring->records ||
+	fwrite(&header, sizeof(header), 1, ring->file) != 1)
+    {
+	free(ring->records);
+	fclose(ring->file);
+	free(ring);
+	return NULL;
+    }
+
+    ring->mask = capacity - 1;
+    ring->overflow = overflow;
+    ring->dropped = 0;
+    ring->tail_cache = 0;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->stop, false);
+
+    if (pthread_create(&ring->writer, NULL, writer_main, ring) != 0)
+    {
+	free(ring->records);
+	fclose(ring->file);
+	free(ring);
+	return NULL;
+    }
+
+    return ring;
+}
+
+
+/* Queue a record */
+void trace_write(trace_ring_t *ring, const trace_record_t *record)
+{
+    size_t head;
+
+    head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head - ring->tail_cache > ring->mask)
+    {
+	ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	while (head - ring->tail_cache > ring->mask)
+	{
+	    if (ring->overflow == TRACE_OVERFLOW_DROP)
+	    {
+		ring->dropped++;
+		return;
+	    }
+	    sched_yield();
+	    ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	}
+    }
+
+    ring->records[head & ring->mask] = *record;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+
+/* Flush and close the trace, returns the number of records dropped */
+uint64_t trace_close(trace_ring_t *ring)
+{
+    uint64_t dropped = ring->dropped;
+
+    atomic_store_explicit(&ring->stop, true, memory_order_release);
+    pthread_join(ring->writer, NULL);
+
+    /* the header is written before the count is known */
+    if (fseek(ring->file, offsetof(trace_file_header_t, dropped), SEEK_SET) == 0)
+	fwrite(&dropped, sizeof(dropped), 1, ring->file);
+    fclose(ring->file);
+    free(ring->records);
+    free(ring);
+
+    return dropped;
+}
+
+
+/*
+ * Text form of a record, as printed by the TRACE_INSTRUCTION level or
+ * with `registers` by TRACE_FULL. No trailing newline.
+ */
+int trace_format(char *buffer, size_t size, const trace_record_t *record,
+		 bool registers)
+{
+    char text[32];
+    int length;
+
+    disasm_format(text, sizeof(text), record->opcode, record->imm);
+    length = snprintf(buffer, size, "[0x%04X] %s%s", record->pc, text,
+		      record->flags & TRACE_RECORD_UNSUPPORTED ?
+		      "ERROR: failed to execute instruction" : "");
+    if (registers && length >= 0 && (size_t)length < size)
+    {
+	length += snprintf(buffer + length, size - length,
+			   "\t; A: 0x%02X F: 0x%02X BC: 0x%04X DE: 0x%04X HL: 0x%04X"
+			   " SP: 0x%04X CYCLES: %llu",
+			   record->af >> 8, record->af & 0xFF, record->bc,
+			   record->de, record->hl, record->sp,
+			   (unsigned long long)record->cycles);
+    }
+    return length;
+}
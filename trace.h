@@ -0,0 +1,73 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Compile-time trace level, e.g. CFLAGS=-DTRACE_LEVEL=0 ./compile
+ *
+ *   TRACE_OFF          nothing is formatted or printed while executing
+ *   TRACE_INSTRUCTION  one "[PC] disassembly" line per instruction
+ *   TRACE_FULL         as above, followed by the registers and cycle count
+ *
+ * At any level but TRACE_OFF the trace can instead be recorded in binary
+ * with trace_open(); records are queued in a ring buffer and written out
+ * by a background thread, and tools/trace_decode turns the file back into
+ * the text form. Each open trace has its own ring and writer thread.
+ */
+#define TRACE_OFF         0
+#define TRACE_INSTRUCTION 1
+#define TRACE_FULL        2
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_INSTRUCTION
+#endif
+
+#define TRACE_FILE_MAGIC   "GBTRACE"
+#define TRACE_FILE_VERSION 1
+
+#define TRACE_RING_DEFAULT_RECORDS (1 << 16)
+
+/* trace_record_t.flags */
+#define TRACE_RECORD_UNSUPPORTED 0x01 /* instruction failed to execute */
+
+/* One executed instruction, registers as they were after it ran */
+typedef struct {
+    uint64_t cycles;
+    uint16_t pc;
+    uint16_t imm;    /* operand bytes, little-endian */
+    uint16_t af;
+    uint16_t bc;
+    uint16_t de;
+    uint16_t hl;
+    uint16_t sp;
+    uint8_t opcode;
+    uint8_t flags;
+} trace_record_t;
+
+/* Written once at the start of a trace file, followed by the records.
+ * Both are in host byte order. */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t dropped; /* records lost to overflow, filled in on close */
+} trace_file_header_t;
+
+/* What trace_write() does when the ring is full */
+typedef enum {
+    TRACE_OVERFLOW_BLOCK, /* wait for the writer thread to make room */
+    TRACE_OVERFLOW_DROP,  /* discard the record and count it */
+} trace_overflow_e;
+
+typedef struct trace_ring_s trace_ring_t;
+
+trace_ring_t *trace_open(const char *path, size_t records, trace_overflow_e overflow);
+void trace_write(trace_ring_t *ring, const trace_record_t *record);
+uint64_t trace_close(trace_ring_t *ring);
+int trace_format(char *buffer, size_t size, const trace_record_t *record,
+		 bool registers);
+
+#endif /* __TRACE_H__ */